@@ -0,0 +1,228 @@
+/*
+ * ColorLed.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "ColorLed.h"
+#include <new>
+
+
+//------------------------------------------------------------------------------------
+//--- PRIVATE TYPES ------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+/** Blancos de 1000K a 10000K en pasos de 500K (aproximación de la radiación de cuerpo negro) */
+static const uint16_t s_kelvin_step = 500;
+static const uint8_t s_kelvin_table[][3] = {
+    {255, 68, 0},
+    {255, 108, 0},
+    {255, 137, 14},
+    {255, 159, 70},
+    {255, 177, 110},
+    {255, 193, 141},
+    {255, 206, 166},
+    {255, 218, 187},
+    {255, 228, 206},
+    {255, 237, 222},
+    {255, 246, 237},
+    {255, 254, 250},
+    {243, 242, 255},
+    {230, 235, 255},
+    {221, 230, 255},
+    {215, 226, 255},
+    {210, 223, 255},
+    {205, 220, 255},
+    {202, 218, 255},
+};
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+ColorLed::ColorLed(const PinName32 pins[], uint8_t channels, Led::LedLogicLevel level, uint32_t period_ms, const LedGammaTable* gamma, LedScheduler* sched){
+    _channels = (channels == 0)? 1 : ((channels > MaxChannels)? MaxChannels : channels);
+    _gamma = gamma;
+    _period_us = (period_ms == 0)? 1000 : (period_ms * 1000);
+    _sched = (sched != NULL)? sched : LedScheduler::getDefault();
+    _sched->reserve(1);
+    _write_fn = (level == Led::OnIsHighLevel)? &ledWrite<LedPwmOutput, LedActiveHigh> : &ledWrite<LedPwmOutput, LedActiveLow>;
+    // las salidas se construyen en el almacenamiento interno (sin memoria dinámica)
+    for(uint8_t c=0;c<MaxChannels;c++){
+        _out[c] = NULL;
+        if(c < _channels){
+            _out[c] = new(_out_storage[c]) PwmOut((PinName)pins[c]);
+            LedPwmOutput::init(*_out[c], _period_us);
+        }
+        _acc[c] = 0;
+        _step[c] = 0;
+    }
+    _mode = ModeIdle;
+    _steps = 0;
+    _phase = 0;
+    _blink_us[0] = 0;
+    _blink_us[1] = 0;
+    // Deja apagado por defecto
+    _shadow_valid = false;
+    commit();
+}
+
+
+//------------------------------------------------------------------------------------
+ColorLed::~ColorLed(){
+    _sched->cancel(&_ev);
+    _sched->release(1);
+    _color = LedColor();
+    commit();
+    for(uint8_t c=0;c<_channels;c++){
+        _out[c]->~PwmOut();
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void ColorLed::setColor(const LedColor& color, uint32_t ms_ramp){
+    uint32_t steps = (ms_ramp * 1000) / _period_us;
+    // actualización atómica de todos los canales frente al callback del timer
+    core_util_critical_section_enter();
+    _sched->cancel(&_ev);
+    if(steps <= 1){
+        _mode = ModeIdle;
+        _color = color;
+        commit();
+        core_util_critical_section_exit();
+        return;
+    }
+    // interpolación lineal en Q16.16: la división se realiza aquí, cada paso es una suma por canal
+    _target = color;
+    for(uint8_t c=0;c<_channels;c++){
+        _acc[c] = ((uint32_t)_color.ch[c] << 16);
+        _step[c] = (int32_t)(((((int64_t)color.ch[c]) << 16) - (int64_t)_acc[c]) / (int64_t)steps);
+    }
+    _steps = steps;
+    _mode = ModeRamp;
+    _sched->schedule(&_ev, callback(this, &ColorLed::rampCb), _period_us);
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+void ColorLed::setColorTemperature(uint16_t kelvin, uint8_t intensity, uint32_t ms_ramp){
+    LedColor color = fromTemperature(kelvin, intensity);
+    if(_channels > ChWhite){
+        uint16_t w = color.ch[ChRed];
+        w = (color.ch[ChGreen] < w)? color.ch[ChGreen] : w;
+        w = (color.ch[ChBlue] < w)? color.ch[ChBlue] : w;
+        color = LedColor(color.ch[ChRed] - w, color.ch[ChGreen] - w, color.ch[ChBlue] - w, w);
+    }
+    setColor(color, ms_ramp);
+}
+
+
+//------------------------------------------------------------------------------------
+void ColorLed::blink(const LedColor& color_on, const LedColor& color_off, uint32_t ms_blink_on, uint32_t ms_blink_off){
+    // sin una de las fases el color es fijo
+    if(ms_blink_on == 0 || ms_blink_off == 0){
+        setColor((ms_blink_on != 0)? color_on : color_off);
+        return;
+    }
+    core_util_critical_section_enter();
+    _sched->cancel(&_ev);
+    _blink_color[0] = color_on;
+    _blink_color[1] = color_off;
+    _blink_us[0] = ms_blink_on * 1000;
+    _blink_us[1] = ms_blink_off * 1000;
+    _phase = 0;
+    _mode = ModeBlink;
+    _color = color_on;
+    commit();
+    _sched->schedule(&_ev, callback(this, &ColorLed::blinkCb), _blink_us[0]);
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+LedColor ColorLed::fromHsv(uint16_t hue, uint8_t sat, uint8_t val){
+    hue = hue % 360;
+    uint8_t region = (uint8_t)(hue / 60);
+    uint32_t rem = ((uint32_t)(hue - (region * 60)) * 255) / 60;
+    uint8_t p = (uint8_t)((val * (255 - sat)) / 255);
+    uint8_t q = (uint8_t)((val * (255 - ((sat * rem) / 255))) / 255);
+    uint8_t t = (uint8_t)((val * (255 - ((sat * (255 - rem)) / 255))) / 255);
+    switch(region){
+        case 0:     return LedColor::rgb(val, t, p);
+        case 1:     return LedColor::rgb(q, val, p);
+        case 2:     return LedColor::rgb(p, val, t);
+        case 3:     return LedColor::rgb(p, q, val);
+        case 4:     return LedColor::rgb(t, p, val);
+        default:    return LedColor::rgb(val, p, q);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+LedColor ColorLed::fromTemperature(uint16_t kelvin, uint8_t intensity){
+    kelvin = (kelvin < MinKelvin)? MinKelvin : ((kelvin > MaxKelvin)? MaxKelvin : kelvin);
+    intensity = (intensity > 100)? 100 : intensity;
+    uint16_t idx = (uint16_t)((kelvin - MinKelvin) / s_kelvin_step);
+    uint32_t frac = (uint32_t)((kelvin - MinKelvin) % s_kelvin_step);
+    const uint8_t* a = s_kelvin_table[idx];
+    const uint8_t* b = s_kelvin_table[(frac != 0)? (idx + 1) : idx];
+    uint16_t ch[3];
+    for(uint8_t c=0;c<3;c++){
+        uint32_t v = (((uint32_t)a[c] * 257 * (s_kelvin_step - frac)) + ((uint32_t)b[c] * 257 * frac)) / s_kelvin_step;
+        ch[c] = (uint16_t)(((v * intensity) + 50) / 100);
+    }
+    return LedColor(ch[0], ch[1], ch[2]);
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void ColorLed::rampCb(){
+    // el último paso fija el destino exacto en todos los canales a la vez
+    if(--_steps == 0){
+        _color = _target;
+        _mode = ModeIdle;
+        commit();
+        return;
+    }
+    for(uint8_t c=0;c<_channels;c++){
+        _acc[c] += (uint32_t)_step[c];
+        _color.ch[c] = (uint16_t)(_acc[c] >> 16);
+    }
+    commit();
+    _sched->scheduleAt(&_ev, callback(this, &ColorLed::rampCb), _ev.deadline + _period_us);
+}
+
+
+//------------------------------------------------------------------------------------
+void ColorLed::blinkCb(){
+    _phase ^= 1;
+    _color = _blink_color[_phase];
+    commit();
+    // deadline absoluto encadenado con el anterior (sin deriva por latencia)
+    _sched->scheduleAt(&_ev, callback(this, &ColorLed::blinkCb), _ev.deadline + _blink_us[_phase]);
+}
+
+
+//------------------------------------------------------------------------------------
+void ColorLed::commit(){
+    for(uint8_t c=0;c<_channels;c++){
+        if(!_shadow_valid || _shadow.ch[c] != _color.ch[c]){
+            _write_fn(_out[c], _color.ch[c], _gamma, _period_us, NULL);
+        }
+    }
+    _shadow = _color;
+    _shadow_valid = true;
+}
+
@@ -0,0 +1,216 @@
+/*
+ * ColorLed.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	ColorLed gestiona un led multicanal (RGB o RGBW) como una única entidad. Cada orden de color (RGB, HSV o
+ *  temperatura de color) se aplica a todos los canales en una única actualización atómica, y las transiciones
+ *  interpolan linealmente en el espacio de color con aritmética entera (Q16.16), de forma que todos los canales
+ *  comparten un único evento en el planificador y escriben su ancho de pulso en el mismo tick. En el hardware
+ *  los canales de un mismo timer adoptan los nuevos anchos al inicio del siguiente periodo.
+ *
+ *  Las conversiones de HSV y de temperatura de color se realizan al dar la orden, fuera de las interrupciones.
+ *
+ *  Ej. de uso:
+ *      static const PinName32 rgb_pins[] = {PA_8, PA_9, PA_10};
+ *      ColorLed status(rgb_pins, 3);
+ *      status.setHsv(120, 255, 255, 500);          // verde en 500ms
+ *      status.setColorTemperature(2700, 50, 1000);  // blanco cálido al 50% en 1s
+ *
+ */
+
+#ifndef __ColorLed__H
+#define __ColorLed__H
+
+#include "mbed.h"
+#include "PwmOut.h"
+#include "Led.h"
+
+
+/** Color: intensidad Q16 de cada canal (rojo, verde, azul, blanco) */
+struct LedColor{
+    uint16_t ch[4];                                         /// Intensidad de cada canal (0 .. 0xFFFF)
+
+    constexpr LedColor(uint16_t r = 0, uint16_t g = 0, uint16_t b = 0, uint16_t w = 0) : ch{r, g, b, w} {}
+
+	/** Construye un color con canales de 8 bits */
+    static constexpr LedColor rgb(uint8_t r, uint8_t g, uint8_t b, uint8_t w = 0) {
+        return LedColor((uint16_t)(r * 257), (uint16_t)(g * 257), (uint16_t)(b * 257), (uint16_t)(w * 257));
+    }
+
+    bool operator==(const LedColor& c) const { return (ch[0] == c.ch[0] && ch[1] == c.ch[1] && ch[2] == c.ch[2] && ch[3] == c.ch[3]); }
+    bool operator!=(const LedColor& c) const { return !(*this == c); }
+};
+
+
+
+class ColorLed{
+  public:
+
+    /** Canales */
+    enum Channel{
+        ChRed,
+        ChGreen,
+        ChBlue,
+        ChWhite,
+    };
+
+    static const uint8_t MaxChannels = 4;                   /// Nº máximo de canales
+    static const uint16_t MinKelvin = 1000;                 /// Temperatura de color mínima
+    static const uint16_t MaxKelvin = 10000;                /// Temperatura de color máxima
+
+
+	/** Constructor
+     *  @param pins GPIOs de cada canal en el orden rojo, verde, azul y blanco
+     *  @param channels Nº de canales (3: RGB, 4: RGBW)
+     *  @param level Nivel de activación lógico (común a todos los canales)
+     *  @param period_ms Periodo del pwm en milisegundos (también periodo de los pasos de las transiciones)
+     *  @param gamma Tabla de corrección gamma (NULL: lineal)
+     *  @param sched Planificador compartido (NULL: planificador por defecto)
+     */
+    ColorLed(const PinName32 pins[], uint8_t channels, Led::LedLogicLevel level = Led::OnIsHighLevel, uint32_t period_ms = 1, const LedGammaTable* gamma = NULL, LedScheduler* sched = NULL);
+    ~ColorLed();
+
+
+	/** setColor
+     *  Inicia la transición de todos los canales hacia un color, que finaliza en el mismo instante en todos ellos
+     *  @param color Color destino
+	 *	@param ms_ramp Duración de la transición (0: instantánea)
+     */
+    void setColor(const LedColor& color, uint32_t ms_ramp = 0);
+
+
+	/** setRgb
+     *  Igual que setColor, con canales de 8 bits (el canal blanco se apaga)
+     */
+    void setRgb(uint8_t r, uint8_t g, uint8_t b, uint32_t ms_ramp = 0) { setColor(LedColor::rgb(r, g, b), ms_ramp); }
+
+
+	/** setRgbw
+     *  Igual que setColor, con canales de 8 bits
+     */
+    void setRgbw(uint8_t r, uint8_t g, uint8_t b, uint8_t w, uint32_t ms_ramp = 0) { setColor(LedColor::rgb(r, g, b, w), ms_ramp); }
+
+
+	/** setHsv
+     *  Igual que setColor, con el color en HSV (ver fromHsv)
+     */
+    void setHsv(uint16_t hue, uint8_t sat, uint8_t val, uint32_t ms_ramp = 0) { setColor(fromHsv(hue, sat, val), ms_ramp); }
+
+
+	/** setColorTemperature
+     *  Igual que setColor, con un blanco de temperatura de color (ver fromTemperature). En leds RGBW la parte
+     *  común a los tres canales de color se entrega con el canal blanco
+     */
+    void setColorTemperature(uint16_t kelvin, uint8_t intensity = 100, uint32_t ms_ramp = 0);
+
+
+	/** off
+     *  Apaga todos los canales
+	 *	@param ms_ramp Duración de la transición (0: instantánea)
+     */
+    void off(uint32_t ms_ramp = 0) { setColor(LedColor(), ms_ramp); }
+
+
+	/** blink
+     *  Alterna entre dos colores. Todos los canales cambian en el mismo tick
+     *  @param color_on Color de la fase de encendido
+     *  @param color_off Color de la fase de apagado
+     *	@param ms_blink_on Tiempo de encendido en ms
+	 *	@param ms_blink_off Tiempo de apagado en ms
+     */
+    void blink(const LedColor& color_on, const LedColor& color_off, uint32_t ms_blink_on, uint32_t ms_blink_off);
+
+
+	/** getColor
+     *  @return Color actual
+     */
+    LedColor getColor() const { return _color; }
+
+
+	/** getChannels
+     *  @return Nº de canales
+     */
+    uint8_t getChannels() const { return _channels; }
+
+
+	/** fromHsv
+     *  Convierte un color HSV a RGB en aritmética entera
+     *  @param hue Tono en grados (0-359)
+     *  @param sat Saturación (0-255)
+     *  @param val Valor (0-255)
+     *  @return Color
+     */
+    static LedColor fromHsv(uint16_t hue, uint8_t sat, uint8_t val);
+
+
+	/** fromTemperature
+     *  Obtiene el blanco de una temperatura de color, interpolando una tabla de 500K en 500K
+     *  @param kelvin Temperatura de color (MinKelvin .. MaxKelvin)
+     *  @param intensity Intensidad en porcentaje 0-100%
+     *  @return Color
+     */
+    static LedColor fromTemperature(uint16_t kelvin, uint8_t intensity = 100);
+
+
+  private:
+    enum Mode{
+        ModeIdle,
+        ModeRamp,
+        ModeBlink,
+    };
+
+    union{
+        uint8_t _out_storage[MaxChannels][sizeof(PwmOut)];  /// Almacenamiento de las salidas (sin memoria dinámica)
+        void* _out_align;                                   /// Alineación del almacenamiento
+        uint64_t _out_align64;
+    };
+    PwmOut* _out[MaxChannels];                              /// Salida de cada canal
+    LedWriteFn _write_fn;                                   /// Escritura especializada por nivel lógico
+    uint8_t _channels;                                      /// Nº de canales
+    const LedGammaTable* _gamma;                            /// Tabla de corrección gamma (NULL: lineal)
+    uint32_t _period_us;                                    /// Periodo del pwm en microsegundos
+    LedScheduler* _sched;                                   /// Planificador compartido
+    LedScheduler::Event _ev;                                /// Único evento para todos los canales
+    Mode _mode;                                             /// Actividad en curso
+    LedColor _color;                                        /// Color actual
+    LedColor _shadow;                                       /// Último color escrito en las salidas
+    bool _shadow_valid;                                     /// Flag para indicar que _shadow refleja las salidas
+    LedColor _target;                                       /// Color destino de la transición
+    uint32_t _acc[MaxChannels];                             /// Color en curso de la transición (Q16.16)
+    int32_t _step[MaxChannels];                             /// Incremento por paso de la transición (Q16.16)
+    uint32_t _steps;                                        /// Pasos restantes de la transición
+    LedColor _blink_color[2];                               /// Colores de las fases de parpadeo (encendido, apagado)
+    uint32_t _blink_us[2];                                  /// Duración de las fases de parpadeo
+    uint8_t _phase;                                         /// Fase de parpadeo en curso
+
+
+	/** rampCb
+     *  Callback de cada paso de la transición
+     */
+    void rampCb();
+
+
+	/** blinkCb
+     *  Callback de cada cambio de fase del parpadeo
+     */
+    void blinkCb();
+
+
+	/** commit
+     *  Escribe el color actual en todos los canales en la misma pasada (sólo los canales que cambian)
+     */
+    void commit();
+
+
+	/** Objeto no copiable: las salidas residen en el propio objeto */
+    ColorLed(const ColorLed&);
+    ColorLed& operator=(const ColorLed&);
+};
+
+
+
+#endif /*__ColorLed__H */
+
+/**** END OF FILE ****/
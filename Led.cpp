@@ -6,6 +6,7 @@
  */
 
 #include "Led.h"
+#include "LedGroup.h"
 
 
 //------------------------------------------------------------------------------------
@@ -15,345 +16,1069 @@
 
 #define NULL_CALLBACK               (void(*)())0
  
+LedStats Led::_global_stats;
+LedSeqLock Led::_global_lock;
+
+
 //------------------------------------------------------------------------------------
 //-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
 //------------------------------------------------------------------------------------
 
 
 //------------------------------------------------------------------------------------
-Led::Led(PinName32 led, LedType type, LedLogicLevel level, uint32_t period_ms){
-	// Crea objeto
-    _id = (uint32_t)led;
-    _debug = false;
-    _type = type;
-    _period_ms = period_ms;
-    _max_intensity = 1.0f;
-    _min_intensity = 0;
-    
-    // desactiva el modo de parpadeo
-    _num_blinks = 0;
-    for(uint8_t i=0;i<MaxBlinkCount;i++){
-    	_blinks[i] = 0;
-    }
+Led::Led(PinName32 led, LedType type, LedLogicLevel level, uint32_t period_ms, const LedGammaTable* gamma, LedScheduler* sched){
+	// Crea objeto. Sin modulador, un led LedBamType se gestiona como todo/nada
+    type = (type == LedBamType)? LedOnOffType : type;
+    setup(led, type, period_ms, gamma, sched);
+    // selecciona la función de escritura especializada para el tipo y el nivel lógico
     if(_type == LedOnOffType){
-        _out_01 = new DigitalOut((PinName)led);
+        attachOutput(led, (level == OnIsHighLevel)? &ledWrite<LedDigitalOutput, LedActiveHigh> : &ledWrite<LedDigitalOutput, LedActiveLow>);
     }
     else{
-        _out = new PwmOut((PinName)led);
-        _out->period_ms(_period_ms);
-    }    
-    _level = level;      
-    
+        attachOutput(led, (level == OnIsHighLevel)? &ledWrite<LedPwmOutput, LedActiveHigh> : &ledWrite<LedPwmOutput, LedActiveLow>);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+Led::Led(LedBam* bam, uint8_t bit, LedLogicLevel level, const LedGammaTable* gamma, LedScheduler* sched){
+    setup((PinName32)bit, LedBamType, 0, gamma, sched);
+    // las rampas avanzan como mínimo una trama del modulador por paso
+    _period_us = bam->getFramePeriod();
+    _period_ms = (_period_us + 999) / 1000;
+    _out = new(_out_storage) LedBamChannel(bam, bit);
+    _write_fn = (level == OnIsHighLevel)? &ledWrite<LedBamOutput, LedActiveHigh> : &ledWrite<LedBamOutput, LedActiveLow>;
     // Deja apagado por defecto
-    off(0, 0, 0);
+    applyOff(0, 0, 0);
+    publishState();
 }
 
 
 //------------------------------------------------------------------------------------
 Led::~Led(){
-	off();
-	_tick_blink.detach();
-	_tick_ramp.detach();
-	_tick_duration.detach();
+	// aplica los comandos pendientes antes de liberar el objeto
+	LedCommandQueue* queue = _sched->getQueue();
+	if(queue != NULL){
+		core_util_critical_section_enter();
+		queue->drain();
+		core_util_critical_section_exit();
+	}
+	if(_state_table != NULL){
+		_state_table->detach(this);
+	}
+	// descarta todas las capas temporales
+	applyOff(0, 0, 0, LayerAlarm);
+	_sched->cancel(&_ev_blink);
+	_sched->cancel(&_ev_ramp);
+	_sched->cancel(&_ev_duration);
+	_sched->cancel(&_ev_dither);
+	if(_ready){
+		_sched->release(EventsPerLed);
+	}
+	// las capas ya no ejecutan patrones: se liberan los del cambio preparado
+	for(uint8_t i=0;i<2;i++){
+		if(_stage[i].is_pattern){
+			LedPatternRegistry::getDefault()->release(_stage[i].pattern);
+			_stage[i].is_pattern = false;
+		}
+	}
+	// si se destruye dentro de una pasada del planificador, la escritura pendiente se realiza ahora
+	if(_flush.queued){
+		_sched->undefer(&_flush);
+		flushOutput();
+	}
+	// la salida reside en el propio objeto: sólo se invoca su destructor
 	if(_type == LedOnOffType){
-		delete(_out_01);
+		static_cast<DigitalOut*>(_out)->~DigitalOut();
+	}
+	else if(_type == LedBamType){
+		static_cast<LedBamChannel*>(_out)->~LedBamChannel();
 	}
 	else{
-		delete(_out);
+		static_cast<PwmOut*>(_out)->~PwmOut();
 	}
 }
 
 
 //------------------------------------------------------------------------------------
-void Led::on(uint32_t ms_duration, uint8_t intensity, uint32_t ms_ramp){
-	if(_stat == LedIsBlinking){
-		_tick_blink.detach();
-	}
-	if(_type == LedDimmableType){
-		_tick_ramp.detach();
-	}
-	if(_istemp){
-		_tick_duration.detach();
-	}
-    _istemp = false;
-    // si es temporal...
-    if(ms_duration > 0){
-        // hace un backup del estado actual y lanza el timer
-        _istemp = true;
-        _bkp_stat = _stat;
-        _tick_duration.attach_us(callback(this, &Led::temporalCb), (ms_duration * 1000));
-    }
-    _stat = LedIsOn;
-    // Si no hay rampa...
-    if(ms_ramp == 0){
-        _action = LedGoOnEnd;
-        if(_type == LedOnOffType){
-           	uint8_t value  = (intensity != 0)? 1 : 0;
-			value = (_level == OnIsHighLevel)? value : (1 - value);
-			_max_intensity = value;
-			_intensity = value;
-			_out_01->write(value);
-        }
-        else{
-            _max_intensity = convertIntensity(intensity);
-            _intensity = _max_intensity;
-            _out->write(_intensity);        
-        }
+int Led::on(uint32_t ms_duration, uint8_t intensity, uint32_t ms_ramp, LedLayer layer){
+    return on(ms_duration, LedLevel(convertIntensity(intensity)), ms_ramp, layer);
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::on(uint32_t ms_duration, LedLevel intensity, uint32_t ms_ramp, LedLayer layer){
+    int result;
+    LED_TRACE(LedTrace::EvOn, _id, intensity.value, layer);
+    if(!postCommand(LedCommand(this, LedCommand::OpOn, ms_duration, ms_ramp, 0, intensity.value, 0, layer), result)){
+        applyOn(ms_duration, intensity.value, ms_ramp, layer);
+        publishState();
     }
-    // si hay rampa, la inicia
-    else{
-        _action = LedGoingOn;
-        _tick_ramp.attach_us(callback(this, &Led::rampOnCb), (ms_ramp * 1000));
-    }    
+    return result;
 }
 
 
 //------------------------------------------------------------------------------------
-void Led::off(uint32_t ms_duration, uint8_t intensity, uint32_t ms_ramp){
-	if(_stat == LedIsBlinking){
-		_tick_blink.detach();
+int Led::off(uint32_t ms_duration, uint8_t intensity, uint32_t ms_ramp, LedLayer layer){
+    return off(ms_duration, LedLevel(convertIntensity(intensity)), ms_ramp, layer);
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::off(uint32_t ms_duration, LedLevel intensity, uint32_t ms_ramp, LedLayer layer){
+    int result;
+    LED_TRACE(LedTrace::EvOff, _id, intensity.value, layer);
+    if(!postCommand(LedCommand(this, LedCommand::OpOff, ms_duration, ms_ramp, 0, intensity.value, 0, layer), result)){
+        applyOff(ms_duration, intensity.value, ms_ramp, layer);
+        publishState();
+    }
+    return result;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration, uint8_t intensity_on, uint8_t intensity_off, LedLayer layer){
+    return blink(ms_blink_on, ms_blink_off, ms_duration, LedLevel(convertIntensity(intensity_on)), LedLevel(convertIntensity(intensity_off)), layer);
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration, LedLevel intensity_on, LedLevel intensity_off, LedLayer layer){
+    int result;
+    LED_TRACE(LedTrace::EvBlink, _id, intensity_on.value, layer);
+    if(!postCommand(LedCommand(this, LedCommand::OpBlink, ms_blink_on, ms_blink_off, ms_duration, intensity_on.value, intensity_off.value, layer), result)){
+        applyBlink(ms_blink_on, ms_blink_off, ms_duration, intensity_on.value, intensity_off.value, layer);
+        publishState();
+    }
+    return result;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::setPeriodUs(uint32_t period_us){
+    if(_type != LedDimmableType || period_us == 0){
+        return -1;
+    }
+    core_util_critical_section_enter();
+    _period_us = period_us;
+    _period_ms = (period_us + 999) / 1000;
+    LedPwmOutput::init(*static_cast<PwmOut*>(_out), _period_us);
+    // el ancho de pulso depende del periodo: se fuerza la escritura
+    _shadow_valid = false;
+    writeOutput();
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::setDithering(bool enable, uint32_t tick_us){
+    if(_type != LedDimmableType){
+        return -1;
+    }
+    core_util_critical_section_enter();
+    _dither = enable;
+    _dither_us = tick_us;
+    _dither_err = 0;
+    if(!enable){
+        _sched->cancel(&_ev_dither);
+    }
+    _shadow_valid = false;
+    writeOutput();
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::setSlack(uint32_t slack_us){
+    // se aplica en la siguiente planificación de cada evento
+    core_util_critical_section_enter();
+    _ev_blink.slack = slack_us;
+    _ev_duration.slack = slack_us;
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::setRampCurve(LedEasing curve){
+    _ramp_table = LedRamp::getTable(curve);
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::setRampCurve(const uint16_t* table){
+    _ramp_table = (table != NULL)? table : LedRamp::getTable(LedEasingLinear);
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::updateBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off){
+    // durante el parpadeo, blinkCb adopta los dos tiempos a la vez en el siguiente flanco. Un patrón en
+    // ejecución no se sustituye: sólo se guardan los tiempos, como en cualquier otro estado
+    if(_layers[_top].stat == LedIsBlinking && publishStage(NULL, ms_blink_on, ms_blink_off, SwapAtEdge) == 0){
+        return 0;
+    }
+    int result;
+    if(!postCommand(LedCommand(this, LedCommand::OpUpdateBlinker, ms_blink_on, ms_blink_off), result)){
+        applyBlinker(ms_blink_on, ms_blink_off);
+    }
+    return result;
+}    
+
+
+//------------------------------------------------------------------------------------
+int Led::stageBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off, LedSwapPoint at){
+    if(ms_blink_on == 0 && ms_blink_off == 0){
+        return -1;
+    }
+    if(publishStage(NULL, ms_blink_on, ms_blink_off, at) != 0){
+        return updateBlinker(ms_blink_on, ms_blink_off);
+    }
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::stagePattern(LedPatternHandle pattern, LedSwapPoint at){
+    if(pattern == NULL){
+        return -1;
+    }
+    if(publishStage(pattern, 0, 0, at) != 0){
+        return play(pattern);
+    }
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::stageBlinkMode(const uint32_t blinks[], uint8_t count, LedSwapPoint at){
+	if(count == 0 || count > MaxBlinkCount){
+		return -1;
 	}
-	if(_type == LedDimmableType){
-		_tick_ramp.detach();
+	LedPatternHandle pattern = LedPatternRegistry::getDefault()->intern(blinks, count);
+	int result = stagePattern(pattern, at);
+	// el cambio preparado (o la orden play) mantiene su propia referencia
+	LedPatternRegistry::getDefault()->release(pattern);
+	return result;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::setBlinkMode(const uint32_t blinks[], uint8_t count){
+	LED_TRACE(LedTrace::EvSetBlinkMode, _id, count);
+	if(count > MaxBlinkCount){
+		return -1;
 	}
-	if(_istemp){
-		_tick_duration.detach();
+	// la lista se registra una única vez: el led sólo guarda el handle y su cursor
+	LedPatternHandle pattern = NULL;
+	if(count > 0){
+		pattern = LedPatternRegistry::getDefault()->intern(blinks, count);
+		if(pattern == NULL){
+			return -1;
+		}
 	}
-    _istemp = false;
-    // si es temporal...
-    if(ms_duration > 0){
-        // hace un backup del estado actual y lanza el timer
-        _istemp = true;
-        _bkp_stat = _stat;
-        _tick_duration.attach_us(callback(this, &Led::temporalCb), (ms_duration * 1000));
+	// la referencia obtenida en el registro pasa al comando
+	return postPlay(pattern, 0, LayerNotification);
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::cancelBlinkMode(){
+    int result;
+    LED_TRACE(LedTrace::EvCancelBlinkMode, _id, 0);
+    if(!postCommand(LedCommand(this, LedCommand::OpCancelBlinkMode), result)){
+        applyCancelBlinkMode();
+        publishState();
     }
+    return result;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::play(LedPatternHandle pattern, uint32_t ms_duration, LedLayer layer){
+    LED_TRACE(LedTrace::EvPlay, _id, layer);
+    LedPatternRegistry::getDefault()->acquire(pattern);
+    return postPlay(pattern, ms_duration, layer);
+}
+
+
+
+//------------------------------------------------------------------------------------
+void Led::attachStats(LedStats* stats){
+    // las estadísticas propias parten del estado actual
+    core_util_critical_section_enter();
+    if(stats != NULL){
+        stats->clear();
+        stats->writes_issued = _writes_issued;
+        stats->writes_suppressed = _writes_suppressed;
+        stats->stat = _stat;
+        stats->stat_since = _stat_since;
+    }
+    _stats = stats;
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::getStats(LedStats& stats) const{
+    if(_stats == NULL){
+        return -1;
+    }
+    return _stats_lock.read(stats, *_stats);
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::getState(LedState& state) const{
+    if(_state_table != NULL){
+        return _state_table->_lock.read(state, *_state);
+    }
+    core_util_critical_section_enter();
+    fillState(state);
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::getGlobalStats(LedStats& stats){
+    return _global_lock.read(stats, _global_stats);
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- PROTECTED METHODS IMPLEMENTATION ------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+Led::Led(PinName32 led, LedType type, uint32_t period_ms, const LedGammaTable* gamma, LedScheduler* sched, LedWriteFn write_fn){
+    setup(led, type, period_ms, gamma, sched);
+    attachOutput(led, write_fn);
+}
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void Led::setup(PinName32 led, LedType type, uint32_t period_ms, const LedGammaTable* gamma, LedScheduler* sched){
+    _id = (uint32_t)led;
+    _sched = (sched != NULL)? sched : LedScheduler::getDefault();
+    // el montículo del planificador debe admitir todos los eventos del led a la vez
+    _ready = (_sched->reserve(EventsPerLed) == 0);
+    _debug = false;
+    _type = type;
+    _period_ms = period_ms;
+    _period_us = period_ms * 1000;
+    _intensity = 0;
+    _shadow = 0;
+    _shadow_valid = false;
+    _dither = false;
+    _dither_err = 0;
+    _dither_us = 0;
+    _stats = NULL;
+    _writes_issued = 0;
+    _writes_suppressed = 0;
     _stat = LedIsOff;
-    // Si no hay rampa...
-    if(ms_ramp == 0){        
-        _action = LedGoOffEnd;
-        if(_type == LedOnOffType){
-        	uint8_t value  = (intensity != 0)? 1 : 0;
-        	value = (_level == OnIsHighLevel)? value : (1 - value);
-        	_min_intensity = value;
-        	_intensity = value;
-            _out_01->write(value);
-        }
-        else{
-            _min_intensity = convertIntensity(intensity);
-            _intensity = _min_intensity;
-            _out->write(_intensity);        
-        }
+    _stat_since = _sched->now();
+    _ramp_table = LedRamp::getTable(LedEasingLinear);
+    _gamma = gamma;
+
+    // capa base apagada y sin capas temporales
+    for(uint8_t i=0;i<MaxLayers;i++){
+        _layers[i].stat = LedIsOff;
+        _layers[i].active = (i == LayerBase);
+        _layers[i].max_intensity = IntensityFullScale;
+        _layers[i].min_intensity = 0;
+        _layers[i].pattern_level = 0;
+        _layers[i].ms_blink_on = 0;
+        _layers[i].ms_blink_off = 0;
+        _layers[i].until = 0;
+        _layers[i].pattern = NULL;
+        _layers[i].cursor.stop();
+    }
+    _top = LayerBase;
+    _pattern_deadline = 0;
+    _group = NULL;
+    for(uint8_t i=0;i<2;i++){
+        _stage[i].ms_blink_on = 0;
+        _stage[i].ms_blink_off = 0;
+        _stage[i].at = SwapAtCycle;
+        _stage[i].is_pattern = false;
+    }
+    _stage_ready = 0;
+    _state = NULL;
+    _state_table = NULL;
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::attachOutput(PinName32 led, LedWriteFn write_fn){
+    // construye la salida en el almacenamiento interno (sin memoria dinámica)
+    if(_type == LedOnOffType){
+        DigitalOut* out = new(_out_storage) DigitalOut((PinName)led);
+        LedDigitalOutput::init(*out, _period_us);
+        _out = out;
     }
-    // si hay rampa, la inicia
     else{
-        _action = LedGoingOff;
-        _tick_ramp.attach_us(callback(this, &Led::rampOffCb), (ms_ramp * 1000));
-    }    
+        PwmOut* out = new(_out_storage) PwmOut((PinName)led);
+        LedPwmOutput::init(*out, _period_us);
+        _out = out;
+    }
+    _write_fn = write_fn;
+
+    // Deja apagado por defecto
+    applyOff(0, 0, 0);
+    publishState();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::applyOn(uint32_t ms_duration, uint16_t intensity, uint32_t ms_ramp, uint8_t layer){
+    Layer& l = selectLayer(ms_duration, layer);
+    l.stat = LedIsOn;
+    l.max_intensity = intensity;
+    // una capa oculta por otra de mayor prioridad sólo actualiza su estado
+    if(&l != &_layers[_top]){
+        return;
+    }
+    // Si no hay rampa...
+    if(ms_ramp == 0){
+        activate();
+        return;
+    }
+    // si hay rampa, la inicia con la duración total indicada
+    stopActivity();
+    _action = LedGoingOn;
+    startRamp(l.max_intensity, ms_ramp);
+    updateStat();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::applyOff(uint32_t ms_duration, uint16_t intensity, uint32_t ms_ramp, uint8_t layer){
+    Layer& l = selectLayer(ms_duration, layer);
+    l.stat = LedIsOff;
+    l.min_intensity = intensity;
+    if(&l != &_layers[_top]){
+        return;
+    }
+    if(ms_ramp == 0){
+        activate();
+        return;
+    }
+    stopActivity();
+    _action = LedGoingOff;
+    startRamp(l.min_intensity, ms_ramp);
+    updateStat();
 }
 
 
 //------------------------------------------------------------------------------------
-void Led::blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration, uint8_t intensity_on, uint8_t intensity_off){
-    // si no hay temporizaciones de On y Off, no permite la ejecucin
+void Led::applyBlink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration, uint16_t intensity_on, uint16_t intensity_off, uint8_t layer){
+    // si no hay temporizaciones de On y Off, no permite la ejecución
     if(ms_blink_on == 0 && ms_blink_off == 0){
         return;
     }
-	if(_stat == LedIsBlinking){
-		_tick_blink.detach();
+    Layer& l = selectLayer(ms_duration, layer);
+    l.stat = LedIsBlinking;
+    l.ms_blink_on = ms_blink_on;
+    l.ms_blink_off = ms_blink_off;
+    l.max_intensity = intensity_on;
+    l.min_intensity = intensity_off;
+    if(&l == &_layers[_top]){
+        activate();
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::applyBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off){
+    _layers[_top].ms_blink_on = ms_blink_on;
+    _layers[_top].ms_blink_off = ms_blink_off;
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::applyCancelBlinkMode(){
+	applyOff(0, 0, 0, LayerNotification);
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::applyPlay(LedPatternHandle pattern, uint32_t ms_duration, uint8_t layer){
+	Layer& l = selectLayer(ms_duration, layer);
+	l.stat = LedIsPlaying;
+	l.max_intensity = IntensityFullScale;
+	l.min_intensity = 0;
+	l.pattern_level = _intensity;
+	startPattern(l, pattern);
+	if(&l == &_layers[_top]){
+		activate();
 	}
-	if(_type == LedDimmableType){
-		_tick_ramp.detach();
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::postPlay(LedPatternHandle pattern, uint32_t ms_duration, uint8_t layer){
+	int result;
+	LedCommand cmd(this, LedCommand::OpPlay, ms_duration, 0, 0, 0, 0, layer);
+	cmd.pattern = pattern;
+	if(!postCommand(cmd, result)){
+		applyPlay(pattern, ms_duration, layer);
+		publishState();
+		LedPatternRegistry::getDefault()->release(pattern);
 	}
-	if(_istemp){
-		_tick_duration.detach();
+	else if(result != 0){
+		LedPatternRegistry::getDefault()->release(pattern);
 	}
-    
-    _istemp = false;
-    _ms_blink_on = ms_blink_on;
-    _ms_blink_off = ms_blink_off;
-    // si es temporal...
-    if(ms_duration > 0){
-        // hace un backup del estado actual y lanza el timer
-        _istemp = true;
-        _bkp_stat = _stat;
-        _tick_duration.attach_us(callback(this, &Led::temporalCb), (ms_duration * 1000));
-    }
-    _stat = LedIsBlinking;    
-    _action = LedGoOnEnd;
-    if(_type == LedOnOffType){
-        _max_intensity = convertIntensity(100);
-        _min_intensity = convertIntensity(0);
-        _intensity = _max_intensity;
-        _out_01->write((uint8_t)_intensity);
-    }
-    else{
-        _max_intensity = convertIntensity(intensity_on);
-        _min_intensity = convertIntensity(intensity_off);
-        _intensity = _max_intensity;
-        _out->write(_intensity);        
+	return result;
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::startPattern(Layer& l, LedPatternHandle pattern){
+	LedPatternRegistry::getDefault()->acquire(pattern);
+	LedPatternRegistry::getDefault()->release(l.pattern);
+	l.pattern = pattern;
+	l.cursor.start(pattern);
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::stopPattern(Layer& l){
+	l.cursor.stop();
+	LedPatternRegistry::getDefault()->release(l.pattern);
+	l.pattern = NULL;
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::apply(const LedCommand& cmd){
+    switch(cmd.op){
+        case LedCommand::OpOn:              applyOn(cmd.arg0, cmd.level0, cmd.arg1, cmd.layer); break;
+        case LedCommand::OpOff:             applyOff(cmd.arg0, cmd.level0, cmd.arg1, cmd.layer); break;
+        case LedCommand::OpBlink:           applyBlink(cmd.arg0, cmd.arg1, cmd.arg2, cmd.level0, cmd.level1, cmd.layer); break;
+        case LedCommand::OpCancelBlinkMode: applyCancelBlinkMode(); break;
+        case LedCommand::OpUpdateBlinker:   applyBlinker(cmd.arg0, cmd.arg1); break;
+        case LedCommand::OpPlay:
+            applyPlay(cmd.pattern, cmd.arg0, cmd.layer);
+            LedPatternRegistry::getDefault()->release(cmd.pattern);
+            break;
+        default: break;
     }
-    _tick_blink.attach_us(callback(this, &Led::blinkCb), (_ms_blink_on * 1000));
+    publishState();
 }
 
 
 //------------------------------------------------------------------------------------
-void Led::updateBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off){
-    _ms_blink_on = ms_blink_on;
-    _ms_blink_off = ms_blink_off;
-}    
+bool Led::postCommand(const LedCommand& cmd, int& result){
+    result = 0;
+    LedCommandQueue* queue = _sched->getQueue();
+    if(queue == NULL){
+        return false;
+    }
+    // el estado del led sólo se modifica en el contexto del planificador
+    if(queue->post(cmd) != 0){
+        result = -1;
+        return true;
+    }
+    _sched->wakeup();
+    return true;
+}
 
 
 //------------------------------------------------------------------------------------
-int Led::setBlinkMode(const uint32_t blinks[], uint8_t count){
-	if(count > MaxBlinkCount){
-		return -1;
-	}
-	_num_blinks = count;
-	for(int i=0;i<_num_blinks;i++){
-		_blinks[i] = blinks[i];
-	}
-	_curr_blink = -1;
-	_executeBlinkMode();
-	return 0;
+void Led::joinGroup(LedGroup* group){
+    if(_group != NULL){
+        _group->leave(this);
+    }
+    stopActivity();
+    core_util_atomic_store_u32(&_stage_ready, 0);
+    // el grupo gestiona la salida: se descartan el patrón y las capas temporales
+    for(uint8_t i=0;i<MaxLayers;i++){
+        _layers[i].active = (i == LayerBase);
+        stopPattern(_layers[i]);
+    }
+    _layers[LayerBase].stat = LedIsBlinking;
+    updateTop();
+    updateStat();
+    _group = group;
+    publishState();
 }
 
 
+//------------------------------------------------------------------------------------
+void Led::leaveGroup(){
+    _group = NULL;
+    // conserva la intensidad actual como estado estable
+    Layer& l = _layers[LayerBase];
+    if(_intensity != 0){
+        l.stat = LedIsOn;
+        l.max_intensity = _intensity;
+        _action = LedGoOnEnd;
+    }
+    else{
+        l.stat = LedIsOff;
+        l.min_intensity = _intensity;
+        _action = LedGoOffEnd;
+    }
+    updateStat();
+    publishState();
+}
+
 
 //------------------------------------------------------------------------------------
-//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+void Led::groupWrite(uint16_t value){
+    _intensity = value;
+    writeOutput();
+    publishState();
+}
+
+
 //------------------------------------------------------------------------------------
+void Led::patternCb(){
+	LED_TRACE(LedTrace::EvPatternCb, _id, _intensity);
+	countCallback(LedStats::CbPattern);
+	if(!swapStage(_layers[_top].cursor.atCycleEnd())){
+		stepPattern();
+	}
+	publishState();
+}
 
 
 //------------------------------------------------------------------------------------
-void Led::_executeBlinkMode(){
-	if(_num_blinks > 0){
-		// siguiente parpadeo
-		_curr_blink = (_curr_blink >= (_num_blinks-1))? 0 : (_curr_blink+1);
-		// si es par correponde un ON
-		if(!(_curr_blink & 1)){
-			on(_blinks[_curr_blink]);
+void Led::stepPattern(){
+	Layer& l = _layers[_top];
+	LedPatternOp op;
+	while(l.cursor.next(op)){
+		uint16_t level = LedPatternOp::toQ16(op.arg8);
+		if(op.code == LedPatternOp::OpSet || (op.code == LedPatternOp::OpRamp && op.arg16 == 0)){
+			_sched->cancel(&_ev_ramp);
+			l.pattern_level = level;
+			_intensity = level;
+			writeOutput();
+		}
+		else if(op.code == LedPatternOp::OpRamp){
+			l.pattern_level = level;
+			_action = (level >= _intensity)? LedGoingOn : LedGoingOff;
+			startRamp(level, op.arg16);
+		}
+		if(op.arg16 != 0){
+			// el siguiente cambio vence respecto al anterior, no respecto al instante actual: la latencia
+			// de la interrupción no se acumula
+			_pattern_deadline += ((uint32_t)op.arg16 * 1000);
+			_sched->scheduleAt(&_ev_blink, callback(this, &Led::patternCb), _pattern_deadline);
 			return;
 		}
-		off(_blinks[_curr_blink]);
 	}
+	// fin del patrón: conserva la intensidad actual como estado estable de la capa
+	stopPattern(l);
+	l.stat = (_intensity != 0)? LedIsOn : LedIsOff;
+	l.max_intensity = (_intensity != 0)? _intensity : l.max_intensity;
+	l.min_intensity = (_intensity != 0)? l.min_intensity : _intensity;
+	updateStat();
 }
 
 
 //------------------------------------------------------------------------------------
-void Led::rampOffCb(){
-    if(_level == OnIsHighLevel){
-        _intensity -= (_max_intensity/10);
-        if(_intensity <= _min_intensity){
-            _tick_ramp.detach();
-            _intensity = _min_intensity;
-            _action = LedGoOffEnd;
-            _out->write(_intensity);
-            return;
-        }
-    }
-    else{
-        _intensity += (_max_intensity/10);
-        if(_intensity >= _max_intensity){
-            _tick_ramp.detach();
-            _intensity = _max_intensity;
-            _action = LedGoOffEnd;
-            _out->write(_intensity);
-            return;
-        }
-    }
-    _out->write(_intensity);
+void Led::startRamp(uint16_t target, uint32_t ms_ramp){
+    _ramp.start(_intensity, target, (ms_ramp * 1000), _period_us, _ramp_table, _sched->now());
+    _sched->scheduleAt(&_ev_ramp, callback(this, &Led::rampCb), _ramp.nextDeadline());
 }
 
 
 //------------------------------------------------------------------------------------
-void Led::rampOnCb(){
-    if(_level == OnIsHighLevel){
-        _intensity += (_max_intensity/10);
-        if(_intensity >= _max_intensity){
-            _tick_ramp.detach();
-            _intensity = _max_intensity;
-            _action = LedGoOnEnd;
-            _out->write(_intensity);
-            return;
-        }
+void Led::rampCb(){
+    LED_TRACE(LedTrace::EvRampCb, _id, _intensity);
+    countCallback(LedStats::CbRamp);
+    // aritmética entera en contexto de interrupción (sin coma flotante)
+    bool running = _ramp.step(_intensity);
+    writeOutput();
+    if(running){
+        _sched->scheduleAt(&_ev_ramp, callback(this, &Led::rampCb), _ramp.nextDeadline());
     }
     else{
-        _intensity -= (_max_intensity/10);
-        if(_intensity <= _min_intensity){
-            _tick_ramp.detach();
-            _intensity = _min_intensity;
-            _action = LedGoOnEnd;
-            _out->write(_intensity);
-            return;
-        }
+        _action = (_action == LedGoingOn)? LedGoOnEnd : LedGoOffEnd;
     }
-    _out->write(_intensity);
+    publishState();
 }
 
 
 //------------------------------------------------------------------------------------
 void Led::blinkCb(){
+    LED_TRACE(LedTrace::EvBlinkCb, _id, _intensity);
+    countCallback(LedStats::CbBlink);
+    // el ciclo se completa al finalizar el apagado
+    if(swapStage(_action != LedGoOnEnd)){
+        publishState();
+        return;
+    }
+    const Layer& l = _layers[_top];
     if(_action == LedGoOnEnd){
-        _intensity = (_level == OnIsHighLevel)? _min_intensity : _max_intensity;
+        _intensity = l.min_intensity;
         _action = LedGoOffEnd;
-        if(_type == LedOnOffType){
-            _out_01->write((uint8_t)_intensity);
-        }
-        else{
-            _out->write(_intensity);        
-        }   
-        _tick_blink.attach_us(callback(this, &Led::blinkCb), (_ms_blink_off * 1000)); 
-                
+        writeOutput();
+        // deadline absoluto encadenado con el anterior (sin deriva por latencia)
+        _sched->scheduleAt(&_ev_blink, callback(this, &Led::blinkCb), _ev_blink.deadline + (l.ms_blink_off * 1000));
     }
     else{
-        _intensity = (_level == OnIsHighLevel)? _max_intensity : _min_intensity;
+        _intensity = l.max_intensity;
         _action = LedGoOnEnd;
-        if(_type == LedOnOffType){
-            _out_01->write((uint8_t)_intensity);
+        writeOutput();
+        _sched->scheduleAt(&_ev_blink, callback(this, &Led::blinkCb), _ev_blink.deadline + (l.ms_blink_on * 1000));
+    }
+    publishState();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::expiryCb(){
+    countCallback(LedStats::CbExpiry);
+    uint32_t t = _ev_duration.deadline;
+    uint8_t top = _top;
+    for(uint8_t i=LayerBase+1;i<MaxLayers;i++){
+        if(_layers[i].active && !before(t, _layers[i].until)){
+            _layers[i].active = false;
+            stopPattern(_layers[i]);
         }
-        else{
-            _out->write(_intensity);        
+    }
+    updateTop();
+    LED_TRACE(LedTrace::EvExpiryCb, _id, _top);
+    // sólo se reevalúa la salida si cambia la capa visible; no se vuelven a ejecutar on(), off() ni blink()
+    if(_top != top){
+        core_util_atomic_store_u32(&_stage_ready, 0);
+        activate();
+    }
+    publishState();
+}
+
+
+//------------------------------------------------------------------------------------
+Led::Layer& Led::selectLayer(uint32_t ms_duration, uint8_t layer){
+    if(_group != NULL){
+        _group->leave(this);
+    }
+    layer = (layer >= MaxLayers)? (MaxLayers - 1) : layer;
+    // una orden nueva descarta el cambio preparado para la actividad anterior
+    core_util_atomic_store_u32(&_stage_ready, 0);
+    Layer* l = &_layers[LayerBase];
+    if(ms_duration == 0){
+        // orden permanente: sustituye la capa base y descarta las temporales hasta la prioridad indicada
+        for(uint8_t i=LayerBase+1;i<=layer;i++){
+            _layers[i].active = false;
+            stopPattern(_layers[i]);
         }
-        _tick_blink.attach_us(callback(this, &Led::blinkCb), (_ms_blink_on * 1000));         
-        
     }
+    else{
+        // la capa base no es temporal: se utiliza la de notificación
+        l = &_layers[(layer == LayerBase)? (uint8_t)LayerNotification : layer];
+        l->active = true;
+        l->until = _sched->now() + (ms_duration * 1000);
+    }
+    stopPattern(*l);
+    updateTop();
+    return *l;
 }
 
 
 //------------------------------------------------------------------------------------
-void Led::temporalCb(){
-    _tick_blink.detach();
-    _tick_ramp.detach();
-    _tick_duration.detach();    
-    _stat = _bkp_stat;
-    // si est activado el modo blink en cascada, lo procesa
-    if(_num_blinks > 0){
-    	_executeBlinkMode();
+void Led::updateTop(){
+    uint8_t top = LayerBase;
+    uint32_t next = 0;
+    for(uint8_t i=LayerBase+1;i<MaxLayers;i++){
+        if(_layers[i].active){
+            next = (top == LayerBase || before(_layers[i].until, next))? _layers[i].until : next;
+            top = i;
+        }
+    }
+    _top = top;
+    // un único evento por led, armado en la expiración más próxima
+    if(top != LayerBase){
+        _sched->scheduleAt(&_ev_duration, callback(this, &Led::expiryCb), next);
     }
-    // en otro caso lo procesa de forma normal
     else{
-		if(_stat == LedIsOff){
-			off(0, (uint8_t)(_min_intensity*100), 0);
-		}
-		else if (_stat == LedIsOn){
-			on(0, (uint8_t)(_max_intensity*100), 0);
-		}
-		else{
-			blink(_ms_blink_on, _ms_blink_off, 0, (uint8_t)(_max_intensity*100), (uint8_t)(_min_intensity*100));
-		}
+        _sched->cancel(&_ev_duration);
     }
 }
 
 
 //------------------------------------------------------------------------------------
-double Led::convertIntensity(uint8_t intensity){
+void Led::activate(){
+    Layer& l = _layers[_top];
+    stopActivity();
+    switch(l.stat){
+        case LedIsOn:
+            _action = LedGoOnEnd;
+            _intensity = l.max_intensity;
+            writeOutput();
+            break;
+        case LedIsBlinking:
+            _action = LedGoOnEnd;
+            _intensity = l.max_intensity;
+            writeOutput();
+            _sched->schedule(&_ev_blink, callback(this, &Led::blinkCb), (l.ms_blink_on * 1000));
+            break;
+        case LedIsPlaying:
+            // recupera el nivel del patrón y lo reanuda en su siguiente instrucción
+            _intensity = l.pattern_level;
+            writeOutput();
+            _pattern_deadline = _sched->now();
+            stepPattern();
+            break;
+        case LedIsOff:
+        default:
+            _action = LedGoOffEnd;
+            _intensity = l.min_intensity;
+            writeOutput();
+            break;
+    }
+    updateStat();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::stopActivity(){
+    _sched->cancel(&_ev_blink);
+    _sched->cancel(&_ev_ramp);
+}
+
+
+//------------------------------------------------------------------------------------
+uint16_t Led::convertIntensity(uint8_t intensity){
     intensity = (intensity > 100)? 100 : intensity;
-    if(_level == OnIsHighLevel){
-    	double fint = (intensity != 0)? (((double)intensity)/100) : 0;
-        return(fint);
+    // la división se realiza fuera de las interrupciones, al configurar el estado
+    return (uint16_t)((((uint32_t)intensity * IntensityFullScale) + 50) / 100);
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::countCallback(uint8_t type){
+    uint32_t late = _sched->getLateness();
+    if(_stats != NULL){
+        _stats_lock.writeBegin();
+        _stats->callbacks[type]++;
+        _stats->lateness.add(late);
+        _stats_lock.writeEnd();
+    }
+    _global_lock.writeBegin();
+    _global_stats.callbacks[type]++;
+    _global_stats.lateness.add(late);
+    _global_lock.writeEnd();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::countWrite(bool issued){
+    _writes_issued += (issued)? 1 : 0;
+    _writes_suppressed += (issued)? 0 : 1;
+    if(_stats != NULL){
+        _stats_lock.writeBegin();
+        _stats->writes_issued = _writes_issued;
+        _stats->writes_suppressed = _writes_suppressed;
+        _stats_lock.writeEnd();
+    }
+    _global_lock.writeBegin();
+    _global_stats.writes_issued += (issued)? 1 : 0;
+    _global_stats.writes_suppressed += (issued)? 0 : 1;
+    _global_lock.writeEnd();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::updateStat(){
+    uint8_t stat = _layers[_top].stat;
+    if(stat == _stat){
+        return;
+    }
+    uint8_t prev = _stat;
+    uint32_t t = _sched->now();
+    uint32_t elapsed = t - _stat_since;
+    _stat = stat;
+    _stat_since = t;
+    if(_stats != NULL){
+        _stats_lock.writeBegin();
+        _stats->time_us[prev] += elapsed;
+        _stats->stat = stat;
+        _stats->stat_since = t;
+        _stats_lock.writeEnd();
+    }
+    // el agregado sólo acumula los intervalos finalizados
+    _global_lock.writeBegin();
+    _global_stats.time_us[prev] += elapsed;
+    _global_lock.writeEnd();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::writeOutput(){
+    if(_flush.queued){
+        countWrite(false);
+        return;
+    }
+    _sched->defer(&_flush, callback(this, &Led::flushOutput));
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::flushOutput(){
+    // registro sombra: en expansores I2C/SPI cada escritura es una transacción en el bus
+    if(_shadow_valid && _shadow == _intensity){
+        countWrite(false);
+        return;
+    }
+    _shadow = _intensity;
+    _shadow_valid = true;
+    countWrite(true);
+    LED_TRACE(LedTrace::EvWrite, _id, _shadow);
+    // tipo de salida y nivel lógico resueltos al construir el objeto
+    _write_fn(_out, _shadow, _gamma, _period_us, (_dither)? &_dither_err : NULL);
+    if(_dither){
+        updateDither();
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::updateDither(){
+    // en los extremos el ancho de pulso es exacto y no hay error que repartir
+    if(_shadow == 0 || _shadow == IntensityFullScale){
+        _sched->cancel(&_ev_dither);
+        return;
+    }
+    if(!LedScheduler::isScheduled(&_ev_dither)){
+        _sched->schedule(&_ev_dither, callback(this, &Led::ditherCb), (_dither_us != 0)? _dither_us : _period_us);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::ditherCb(){
+    // incremental: una suma y una máscara por tick
+    _write_fn(_out, _shadow, _gamma, _period_us, &_dither_err);
+    _sched->scheduleAt(&_ev_dither, callback(this, &Led::ditherCb), _ev_dither.deadline + ((_dither_us != 0)? _dither_us : _period_us));
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::publishState(){
+    if(_state_table == NULL){
+        return;
+    }
+    // se escribe directamente en la entrada: el lector repite la copia si coincide con la actualización
+    _state_table->_lock.writeBegin();
+    fillState(*_state);
+    _state_table->_lock.writeEnd();
+}
+
+
+//------------------------------------------------------------------------------------
+void Led::fillState(LedState& s) const{
+    const Layer& l = _layers[_top];
+    s.id = _id;
+    s.mode = (_group != NULL)? (uint8_t)LedState::ModeGrouped : (uint8_t)l.stat;
+    s.layer = _top;
+    s.intensity = _intensity;
+    s.target = _intensity;
+    s.pattern_pc = (l.stat == LedIsPlaying)? l.cursor.getPosition() : 0;
+    s.flags = 0;
+    s.next_edge = 0;
+    if(_ramp.isRunning() && LedScheduler::isScheduled(&_ev_ramp)){
+        s.target = _ramp.getTarget();
+        s.flags = LedState::FlagRamp | LedState::FlagEdge;
+        s.next_edge = _ramp.nextDeadline();
+    }
+    if(LedScheduler::isScheduled(&_ev_blink) && (!(s.flags & LedState::FlagEdge) || before(_ev_blink.deadline, s.next_edge))){
+        s.flags |= LedState::FlagEdge;
+        s.next_edge = _ev_blink.deadline;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+int Led::publishStage(LedPatternHandle pattern, uint32_t ms_blink_on, uint32_t ms_blink_off, uint8_t at){
+    uint8_t stat = _layers[_top].stat;
+    if(_group != NULL || (stat != LedIsBlinking && stat != LedIsPlaying)){
+        return -1;
+    }
+    // el timer sólo lee el buffer publicado: se escribe el otro y se publica con una única escritura atómica
+    uint8_t w = (core_util_atomic_load_u32(&_stage_ready) == 1)? 1 : 0;
+    Stage& st = _stage[w];
+    if(st.is_pattern){
+        LedPatternRegistry::getDefault()->release(st.pattern);
+    }
+    st.is_pattern = (pattern != NULL);
+    if(st.is_pattern){
+        LedPatternRegistry::getDefault()->acquire(pattern);
+        st.pattern = pattern;
     }
     else{
-    	double fint = (intensity != 1)? (((double)intensity)/100) : 1.0f;
-    	return(1.0f - fint);
+        st.ms_blink_on = ms_blink_on;
+        st.ms_blink_off = ms_blink_off;
+    }
+    st.at = at;
+    core_util_atomic_store_u32(&_stage_ready, w + 1);
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+bool Led::swapStage(bool cycle){
+    uint32_t ready = core_util_atomic_load_u32(&_stage_ready);
+    if(ready == 0){
+        return false;
+    }
+    Stage st = _stage[ready - 1];
+    if(st.at == SwapAtCycle && !cycle){
+        return false;
+    }
+    // la copia mantiene su referencia al patrón: al liberar el buffer el productor puede reescribirlo
+    if(st.is_pattern){
+        LedPatternRegistry::getDefault()->acquire(st.pattern);
+    }
+    // si el productor ha publicado otro cambio durante la copia, se adopta en el siguiente punto
+    if(!core_util_atomic_cas_u32(&_stage_ready, &ready, 0)){
+        if(st.is_pattern){
+            LedPatternRegistry::getDefault()->release(st.pattern);
+        }
+        return false;
     }
+    Layer& l = _layers[_top];
+    if(!st.is_pattern){
+        l.ms_blink_on = st.ms_blink_on;
+        l.ms_blink_off = st.ms_blink_off;
+        if(l.stat == LedIsBlinking){
+            return false;
+        }
+        // de patrón a parpadeo: el encendido comienza en este punto
+        stopPattern(l);
+        l.stat = LedIsBlinking;
+        _sched->cancel(&_ev_ramp);
+        _action = LedGoOnEnd;
+        _intensity = l.max_intensity;
+        writeOutput();
+        _sched->scheduleAt(&_ev_blink, callback(this, &Led::blinkCb), _ev_blink.deadline + (l.ms_blink_on * 1000));
+        updateStat();
+        return true;
+    }
+    startPattern(l, st.pattern);
+    LedPatternRegistry::getDefault()->release(st.pattern);
+    if(l.stat == LedIsPlaying){
+        return false;
+    }
+    // de parpadeo a patrón: comienza en este punto, encadenado con el deadline del flanco
+    l.stat = LedIsPlaying;
+    l.max_intensity = IntensityFullScale;
+    l.min_intensity = 0;
+    l.pattern_level = _intensity;
+    _pattern_deadline = _ev_blink.deadline;
+    stepPattern();
+    updateStat();
+    return true;
 }
+
@@ -4,8 +4,8 @@
  *  Created on: Sep 2017
  *      Author: raulMrello
  *
- *	Led es el mdulo encargado de gestionar la activacin y apagado de un LED. Es posible generar patrones de parpadeo a diferentes
- *  velocidades, con diferente nivel de intensidad, con encendidos y apagados instantneos o en rampa.
+ *	Led es el módulo encargado de gestionar la activación y apagado de un LED. Es posible generar patrones de parpadeo a diferentes
+ *  velocidades, con diferente nivel de intensidad, con encendidos y apagados instantáneos o en rampa.
  *
  */
  
@@ -15,23 +15,65 @@
 #include "mbed.h"
 #include "DigitalOut.h"
 #include "PwmOut.h"
+#include "LedScheduler.h"
+#include "LedGamma.h"
+#include "LedRamp.h"
+#include "LedOutput.h"
+#include "LedCommandQueue.h"
+#include "LedGroup.h"
+#include "LedBam.h"
+#include "LedPattern.h"
+#include "LedPatternRegistry.h"
+#include "LedTrace.h"
+#include "LedStats.h"
+#include "LedState.h"
 #include <list>
+#include <new>
 #if __MBED__==1
 #include "mdf_api_cortex.h"
 #endif
 
 
    
+/** Intensidad de 16 bits (0 .. 0xFFFF = 100%). Tipo propio para distinguir las sobrecargas de 16 bits de las
+ *  de porcentaje: led.on(0, LedLevel(0x0123)) */
+struct LedLevel{
+    uint16_t value;
+    explicit constexpr LedLevel(uint16_t v) : value(v) {}
+};
+
+
 class Led{
   public:
 
-    /** Configuracin para establecer el tipo de led */
+    friend class LedCommandQueue;
+    friend class LedGroup;
+    friend class LedStateTable;
+
+    /** Configuración para establecer el tipo de led */
     enum LedType{
         LedOnOffType,
         LedDimmableType,
+        LedBamType,             /// Salida digital regulada mediante LedBam
     };
   
-    /** Configuracin para establecer la lgica de activacin */
+	/** Capas de prioridad (de menor a mayor). Cada capa mantiene su propia orden y su propia expiración; el led
+	 *  muestra siempre la capa activa de mayor prioridad */
+	enum LedLayer{
+		LayerBase,
+		LayerNotification,
+		LayerAlarm,
+	};
+	static const uint8_t MaxLayers = 3;                     /// Nº de capas
+	static const uint16_t EventsPerLed = 4;                 /// Eventos reservados por led en el planificador (rampa, parpadeo, expiración y dithering)
+
+	/** Punto en el que se aplica un cambio preparado (ver stageBlinker, stagePattern) */
+	enum LedSwapPoint{
+		SwapAtEdge,             /// En el siguiente cambio de nivel
+		SwapAtCycle,            /// Al completar el ciclo de parpadeo o la pasada del patrón en curso
+	};
+
+    /** Configuración para establecer la lógica de activación */
 	enum LedLogicLevel{
 		OnIsLowLevel,
 		OnIsHighLevel
@@ -40,89 +82,301 @@ class Led{
 	/** Constructor
      *  @param led GPIO conectado al led
      *  @param type Tipo de led (DigitalOut o PwmOut)
-     *  @param level Nivel de activacin lgico 
+     *  @param level Nivel de activación lógico 
      *  @param period Periodo del del pwm en milisegundos
+     *  @param gamma Tabla de corrección gamma (NULL: lineal). Ej: &LedGamma<LedCurveCie1931>::table
+     *  @param sched Planificador compartido (NULL: planificador por defecto)
      */
-    Led(PinName32 led, LedType type, LedLogicLevel level = OnIsHighLevel, uint32_t period_ms = 1);
-    ~Led();
+    Led(PinName32 led, LedType type, LedLogicLevel level = OnIsHighLevel, uint32_t period_ms = 1, const LedGammaTable* gamma = NULL, LedScheduler* sched = NULL);
+
+	/** Constructor para leds en salidas digitales reguladas mediante modulación BAM
+     *  @param bam Modulador del puerto al que está conectado el led
+     *  @param bit Bit del puerto
+     *  @param level Nivel de activación lógico
+     *  @param gamma Tabla de corrección gamma (NULL: lineal)
+     *  @param sched Planificador compartido (NULL: planificador por defecto)
+     */
+    Led(LedBam* bam, uint8_t bit, LedLogicLevel level = OnIsHighLevel, const LedGammaTable* gamma = NULL, LedScheduler* sched = NULL);
+    virtual ~Led();
   
   
 	/** on
      *  Inicia el encendido del led, a un nivel de intensidad, con o sin rampa incial y opcionalmente
-     *  con una duracin mxima. Por defecto enciende el led instantneamente
+     *  con una duración máxima. Por defecto enciende el led instantáneamente.
+     *  Con duración, la orden se aplica en la capa indicada (la capa base se trata como notificación) y al
+     *  expirar se muestra de nuevo la capa inferior. Sin duración, la orden sustituye a la capa base y
+     *  descarta las capas temporales hasta la prioridad indicada (igual en off, blink y play)
      *  @param intensity Intensidad en porcentaje 0-100%
-	 *	@param ms_duration Tiempo de duracin, hasta volver al estado anterior
-	 *	@param ms_ramp Tiempo hasta alcanzar la intensidad (0: instantnea, !=0: millisegundos)
+	 *	@param ms_duration Tiempo de duración, hasta volver al estado anterior
+	 *	@param ms_ramp Duración total de la rampa hasta alcanzar la intensidad (0: instantánea, !=0: millisegundos)
+	 *	@param layer Capa de prioridad
+	 *  @return 0 OK, -1 Error (cola de comandos llena: la orden no se aplica)
+	 */
+    int on(uint32_t ms_duration = 0, uint8_t intensity=100, uint32_t ms_ramp = 0, LedLayer layer = LayerNotification);
+
+
+	/** on
+     *  Igual que on(), con la intensidad en 16 bits
+     *  @param intensity Intensidad 0 .. 0xFFFF
 	 */
-    void on(uint32_t ms_duration = 0, uint8_t intensity=100, uint32_t ms_ramp = 0);
+    int on(uint32_t ms_duration, LedLevel intensity, uint32_t ms_ramp = 0, LedLayer layer = LayerNotification);
 
 
     /** off
      *  Inicia el apagado del led, a un nivel de intensidad, con o sin rampa incial y opcionalmente
-     *  con una duracin mxima. Por defecto deja el led apagado instantneamente.
-     *	@param ms_duration Tiempo de duracin, hasta volver al estado anterior
+     *  con una duración máxima. Por defecto deja el led apagado instantáneamente.
+     *	@param ms_duration Tiempo de duración, hasta volver al estado anterior
 	 *  @param intensity Intensidad en porcentaje 0-100%
-	 *	@param ms_ramp Tiempo hasta alcanzar la intensidad (0: instantnea, !=0: millisegundos)
+	 *	@param ms_ramp Duración total de la rampa hasta alcanzar la intensidad (0: instantánea, !=0: millisegundos)
+	 *	@param layer Capa de prioridad
+	 *  @return 0 OK, -1 Error (cola de comandos llena: la orden no se aplica)
 	 */
-    void off(uint32_t ms_duration = 0, uint8_t intensity=0, uint32_t ms_ramp = 0);
+    int off(uint32_t ms_duration = 0, uint8_t intensity=0, uint32_t ms_ramp = 0, LedLayer layer = LayerNotification);
+
+
+    /** off
+     *  Igual que off(), con la intensidad en 16 bits
+	 *  @param intensity Intensidad 0 .. 0xFFFF
+	 */
+    int off(uint32_t ms_duration, LedLevel intensity, uint32_t ms_ramp = 0, LedLayer layer = LayerNotification);
 
 
     /** blink
-     *  Inicia el parpadeo del led, con intensidades mxima y mnima y opcionalmente
-     *  con una duracin mxima. Por defecto el led parpadea de 0 a 1.
+     *  Inicia el parpadeo del led, con intensidades máxima y mínima y opcionalmente
+     *  con una duración máxima. Por defecto el led parpadea de 0 a 1.
      *	@param ms_blink_on Tiempo de encendido en ms
 	 *	@param ms_blink_off Tiempo de apagado en ms
-	 *	@param ms_duration Tiempo de duracin, hasta volver al estado anterior
+	 *	@param ms_duration Tiempo de duración, hasta volver al estado anterior
 	 *  @param intensity_on Intensidad de encendido en porcentaje 0-100%
 	 *  @param intensity_off Intensidad de apagado en porcentaje 0-100%
+	 *	@param layer Capa de prioridad
+	 *  @return 0 OK, -1 Error (cola de comandos llena: la orden no se aplica)
+	 */
+    int blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration = 0, uint8_t intensity_on=100, uint8_t intensity_off=0, LedLayer layer = LayerNotification);
+
+
+    /** blink
+     *  Igual que blink(), con las intensidades en 16 bits
+	 *  @param intensity_on Intensidad de encendido 0 .. 0xFFFF
+	 *  @param intensity_off Intensidad de apagado 0 .. 0xFFFF
 	 */
-    void blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration = 0, uint8_t intensity_on=100, uint8_t intensity_off=0);
+    int blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration, LedLevel intensity_on, LedLevel intensity_off = LedLevel(0), LedLayer layer = LayerNotification);
+
+
+	/** setPeriodUs
+     *  Modifica el periodo del pwm con resolución de microsegundos (sólo leds LedDimmableType). El ancho de
+     *  pulso se cuantifica en microsegundos: con periodos cortos, setDithering recupera la resolución perdida
+     *  @param period_us Periodo en microsegundos
+	 *  @return 0 OK, -1 Error (tipo de led no regulable o periodo nulo)
+     */
+    int setPeriodUs(uint32_t period_us);
+
+
+	/** setDithering
+     *  Activa el dithering temporal sigma-delta del ancho de pulso (sólo leds LedDimmableType). En cada tick
+     *  se reescribe el ancho de pulso acumulando la fracción de microsegundo no representable, de forma que el
+     *  ancho medio conserva los 16 bits de intensidad aunque el timer sólo resuelva microsegundos. El tick sólo
+     *  está planificado mientras la intensidad no es 0 ni 100%. Las escrituras de los ticks no se cuentan en
+     *  las estadísticas ni en las trazas
+     *  @param enable Flag de activación
+     *  @param tick_us Periodo del tick en microsegundos (0: un tick por periodo del pwm)
+	 *  @return 0 OK, -1 Error (tipo de led no regulable)
+     */
+    int setDithering(bool enable, uint32_t tick_us = 0);
+
+
+	/** setSlack
+     *  Establece la tolerancia de los cambios de parpadeo, de patrón y de expiración del led (ver
+     *  LedScheduler): cada cambio puede retrasarse hasta slack_us para agruparse con los de otros leds en un
+     *  único despertar del procesador. Los pasos de las rampas y del dithering no se retrasan
+     *  @param slack_us Tolerancia en microsegundos (0: sin tolerancia)
+     */
+    void setSlack(uint32_t slack_us);
   
   
+	/** setRampCurve
+     *  Selecciona la curva de transición de las rampas
+     *  @param curve Curva precalculada
+     */
+    void setRampCurve(LedEasing curve);
+
+
+	/** setRampCurve
+     *  Instala una curva de transición propia
+     *  @param table Tabla de LedRampTableSize entradas en Q15 (NULL: lineal)
+     */
+    void setRampCurve(const uint16_t* table);
+
+
 	/** updateBlinker
-     *  Modifica los tiempos de parpadeo
+     *  Modifica los tiempos de parpadeo. Durante el parpadeo se aplican en el siguiente cambio de nivel
+     *  (equivale a stageBlinker con SwapAtEdge). Durante un patrón o setBlinkMode sólo se guardan los tiempos,
+     *  sin interrumpir el patrón
      *	@param ms_blink_on Tiempo de encendido en modo parpadeo
 	 *	@param ms_blink_off Tiempo de apagado en modo parpadeo (si =0 modo parpadeo desactivado)
+	 *  @return 0 OK, -1 Error (cola de comandos llena: la orden no se aplica)
+	 */
+    int updateBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off);
+
+
+	/** stageBlinker
+     *  Prepara unos tiempos de parpadeo para la capa visible, que el contexto del timer adopta de forma
+     *  atómica en el punto indicado. Si la capa visible parpadea o ejecuta un patrón, el coste es O(1) y sin
+     *  secciones críticas: se escribe el buffer libre de un doble buffer y se publica con una escritura
+     *  atómica; un segundo cambio antes del punto de cambio sustituye al primero. En otro caso se aplica
+     *  como updateBlinker. Cualquier orden on, off, blink o play descarta el cambio preparado. Un único
+     *  productor por led
+     *	@param ms_blink_on Tiempo de encendido en ms
+	 *	@param ms_blink_off Tiempo de apagado en ms
+	 *	@param at Punto de cambio
+	 *  @return 0 OK, -1 Error (tiempos nulos o cola de comandos llena)
+	 */
+    int stageBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off, LedSwapPoint at = SwapAtCycle);
+
+
+	/** stagePattern
+     *  Prepara un patrón para la capa visible (ver stageBlinker). El patrón nuevo comienza en el punto de
+     *  cambio con el deadline encadenado del anterior, sin reiniciar la temporización. Si la capa visible
+     *  no parpadea ni ejecuta un patrón, se aplica como play en la capa de notificación
+     *  @param pattern Patrón o handle de LedPatternRegistry
+	 *	@param at Punto de cambio
+	 *  @return 0 OK, -1 Error (patrón nulo o cola de comandos llena)
+	 */
+    int stagePattern(LedPatternHandle pattern, LedSwapPoint at = SwapAtCycle);
+
+
+	/** stageBlinkMode
+     *  Igual que stagePattern, con una lista de temporizaciones como en setBlinkMode
+     *  @param blinks Lista de temporizaciones
+     *  @param count Número de temporizaciones (1..16)
+	 *	@param at Punto de cambio
+	 *  @return 0 OK, -1 Error (lista no válida o registro lleno)
 	 */
-    void updateBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off);
+    int stageBlinkMode(const uint32_t blinks[], uint8_t count, LedSwapPoint at = SwapAtCycle);
 
 
     /**
      * Establece un modo de parpadeo basado en una lista de temporizaciones
      * Tiempos en ms--------------  ON  OFF  ON    OFF  ON   OFF
-     * Ej. un parpadeo rpido:    [250, 1000]
-     * Ej. dos parpadeos rpidos: [250, 250, 250, 1000]
-     * Ej. tres parpadeos rpidos:[250, 250, 250, 250, 250, 1000]
+     * Ej. un parpadeo rápido:    [250, 1000]
+     * Ej. dos parpadeos rápidos: [250, 250, 250, 1000]
+     * Ej. tres parpadeos rápidos:[250, 250, 250, 250, 250, 1000]
      * Ej. parpadeos lentos:      [500, 500]
-     * Ej. parpadeos rpidos:     [250, 250]
-     * @param blinks Lista de temporizaciones
-     * @param count Nmero de temporizaciones a realizar hasta un mximo de 16
-	 * @return 0 OK, -1 Error
+     * Ej. parpadeos rápidos:     [250, 250]
+     * La lista se compila y se registra en LedPatternRegistry::getDefault(): los leds con la misma lista
+     * comparten el patrón y la lista no necesita permanecer válida tras la llamada. El patrón se inicia
+     * inmediatamente desde su primer tiempo; para cambiarlo sin cortes utilizar stageBlinkMode
+     * @param blinks Lista de temporizaciones (máximo 65535ms cada una)
+     * @param count Número de temporizaciones a realizar hasta un máximo de 16 (0: detiene el modo)
+	 * @return 0 OK, -1 Error (lista no válida, registro lleno o cola llena)
      */
     int setBlinkMode(const uint32_t blinks[], uint8_t count);
+
+
+	/** play
+     *  Ejecuta un patrón compilado (ver LedPattern) o un handle de LedPatternRegistry. El patrón no se copia:
+     *  debe permanecer válido mientras se ejecuta y puede compartirse entre varios leds. Se detiene con
+     *  cancelBlinkMode o con cualquier orden on, off o blink sin duración; una orden temporal en una capa
+     *  superior lo suspende y al expirar se reanuda con su último nivel
+     *  @param pattern Patrón (NULL: detiene el patrón conservando la intensidad)
+	 *	@param ms_duration Tiempo de duración en su capa (0: permanente)
+	 *	@param layer Capa de prioridad
+	 *  @return 0 OK, -1 Error (cola de comandos llena: la orden no se aplica)
+     */
+    int play(LedPatternHandle pattern, uint32_t ms_duration = 0, LedLayer layer = LayerNotification);
   
 
     /**
      * Cancela el modo blinking
+	 * @return 0 OK, -1 Error (cola de comandos llena: la orden no se aplica)
      */
-    void cancelBlinkMode(){
-    	_num_blinks = 0;
-    	off();
-    }
+    int cancelBlinkMode();
   
 
+	/** isReady
+     *  Indica si el planificador ha admitido la reserva de los eventos del led en la construcción. En otro
+     *  caso (ej. un LedSchedulerT con capacidad insuficiente) las planificaciones del led pueden rechazarse
+     *  (ver LedSchedulerStats::arm_failures)
+     *  @return true si el led está operativo
+     */
+    bool isReady() const { return _ready; }
+
+
+	/** getWritesIssued
+     *  @return Nº de escrituras realizadas en la salida
+     */
+    uint32_t getWritesIssued() const { return _writes_issued; }
+
+
+	/** getWritesSuppressed
+     *  @return Nº de escrituras evitadas (valor ya presente en la salida o agrupadas en la misma pasada del planificador)
+     */
+    uint32_t getWritesSuppressed() const { return _writes_suppressed; }
+
+
+	/** attachStats
+     *  Asocia el almacenamiento de las estadísticas propias del led. Es opcional: sin él, el led sólo
+     *  contabiliza sus escrituras y contribuye al agregado global (ver getGlobalStats)
+     *  @param stats Almacenamiento (debe permanecer válido mientras esté asociado; NULL: desasocia)
+     */
+    void attachStats(LedStats* stats);
+
+
+	/** getStats
+     *  Obtiene una instantánea de las estadísticas del led (callbacks por tipo, escrituras, retraso de los
+     *  callbacks y tiempo en cada estado) sin bloquear al timer. Sólo se contabiliza desde attachStats. El
+     *  tiempo en el estado actual no está incluido en time_us: transcurre desde stat_since
+     *  @param stats Recibe las estadísticas
+	 *  @return 0 OK, -1 Error (sin almacenamiento asociado o actualización en curso, reintentar)
+     */
+    int getStats(LedStats& stats) const;
+
+
+	/** getGlobalStats
+     *  Obtiene una instantánea de las estadísticas agregadas de todos los leds (time_us sólo acumula los
+     *  intervalos finalizados; stat y stat_since no se utilizan)
+     *  @param stats Recibe las estadísticas
+	 *  @return 0 OK, -1 Error (actualización en curso, reintentar)
+     */
+    static int getGlobalStats(LedStats& stats);
+
+
+	/** getState
+     *  Obtiene el estado actual del led (modo, intensidad actual y de destino, posición en el patrón e instante
+     *  del próximo cambio). Si el led está asociado a una LedStateTable se lee su entrada de la tabla sin
+     *  bloquear al timer; en otro caso el estado se obtiene en una sección crítica breve
+     *  @param state Recibe el estado
+	 *  @return 0 OK, -1 Error (actualización en curso, reintentar)
+     */
+    int getState(LedState& state) const;
+
+
 	/** setDebugChannel()
-     *  Instala canal de depuracin
+     *  Instala canal de depuración
      *  @param dbg Logger
      */
     void setDebugChannel(bool dbg) { _debug = dbg; }
  
+
+  protected:
+
+	/** Constructor para clases derivadas con la función de escritura fijada en compilación (ver LedT)
+     *  @param led GPIO conectado al led
+     *  @param type Tipo de led
+     *  @param period_ms Periodo del pwm en milisegundos
+     *  @param gamma Tabla de corrección gamma (NULL: lineal)
+     *  @param sched Planificador compartido (NULL: planificador por defecto)
+     *  @param write_fn Función de escritura especializada
+     */
+    Led(PinName32 led, LedType type, uint32_t period_ms, const LedGammaTable* gamma, LedScheduler* sched, LedWriteFn write_fn);
+
          
   private:
     enum LedStat{
         LedIsOff,        
         LedIsOn,
-        LedIsBlinking        
+        LedIsBlinking,
+        LedIsPlaying
     };
     enum LedAction{
         LedGoingOff,
@@ -130,46 +384,164 @@ class Led{
         LedGoOffEnd,
         LedGoOnEnd,
     };
+
+    /** Estado de una capa de prioridad */
+    struct Layer{
+        uint8_t stat;                                       /// Orden de la capa (LedStat)
+        bool active;                                        /// Flag para indicar que la capa está activa (la base siempre)
+        uint16_t max_intensity;                             /// Máximo nivel de intensidad (Q16)
+        uint16_t min_intensity;                             /// Mínimo nivel de intensidad (Q16)
+        uint16_t pattern_level;                             /// Nivel de la última instrucción set o ramp del patrón (Q16)
+        uint32_t ms_blink_on;                               /// Milisegundos de encendido (parpadeo)
+        uint32_t ms_blink_off;                              /// Milisegundos de apagado (parpadeo)
+        uint32_t until;                                     /// Instante absoluto de expiración (capas temporales)
+        LedPatternHandle pattern;                           /// Patrón en ejecución (con referencia en el registro)
+        LedPatternCursor cursor;                            /// Cursor del patrón en ejecución
+    };
+
+    /** Cambio preparado para el contexto del timer (ver stageBlinker, stagePattern) */
+    struct Stage{
+        union{
+            LedPatternHandle pattern;                       /// Patrón (is_pattern), con referencia hasta reescribir el buffer
+            struct{
+                uint32_t ms_blink_on;                       /// Milisegundos de encendido
+                uint32_t ms_blink_off;                      /// Milisegundos de apagado
+            };
+        };
+        uint8_t at;                                         /// Punto de cambio (LedSwapPoint)
+        bool is_pattern;                                    /// Flag para indicar que el cambio es un patrón
+    };
     
     static const uint32_t GlitchFilterTimeoutUs = 20000;    /// Por defecto 20ms de timeout antiglitch desde el cambio de nivel
-    static const uint8_t MaxBlinkCount = 16;				/// Mximo n de parpadeos en la lista de parpadeos consecutivos
+    static const uint8_t MaxBlinkCount = 16;				/// Máximo nº de parpadeos en la lista de parpadeos consecutivos
+    static const uint16_t IntensityFullScale = 0xFFFF;      /// Intensidad máxima en punto fijo Q16 (100%)
 
     uint32_t _id;                                           /// Led id. Coincide con el PinName32 asociado
-    PwmOut* _out;                                          /// Salida pwm
-    DigitalOut* _out_01;                                   /// Salida binaria 0 1
-    double _intensity;                                      /// Nivel de intensidad
-    double _max_intensity;                                  /// Mximo nivel de intensidad
-    double _min_intensity;                                  /// Mnimo nivel de intensidad
-    LedType _type;                                          /// Tipo de led
-    LedLogicLevel _level;                                   /// Nivel lgico para la activacin
-    LedStat _stat;                                          /// Estado del led
-    LedAction _action;                                      /// Accin en ejecucin del led
+    static const size_t OutStorageSize = (sizeof(PwmOut) > sizeof(DigitalOut))?
+                                         ((sizeof(PwmOut) > sizeof(LedBamChannel))? sizeof(PwmOut) : sizeof(LedBamChannel)) :
+                                         ((sizeof(DigitalOut) > sizeof(LedBamChannel))? sizeof(DigitalOut) : sizeof(LedBamChannel));
+
+    union{
+        uint8_t _out_storage[OutStorageSize];               /// Almacenamiento de la salida (sin memoria dinámica)
+        void* _out_align;                                   /// Alineación del almacenamiento
+        uint64_t _out_align64;
+    };
+    void* _out;                                             /// Salida (PwmOut, DigitalOut o LedBamChannel) alojada en _out_storage
+    LedWriteFn _write_fn;                                   /// Escritura especializada por tipo y nivel lógico
+    uint16_t _intensity;                                    /// Nivel de intensidad (Q16)
+    uint16_t _shadow;                                       /// Último valor escrito en la salida (Q16)
+    bool _shadow_valid;                                     /// Flag para indicar que _shadow refleja el estado de la salida
+    LedScheduler::Deferred _flush;                          /// Escritura diferida al final de la pasada del planificador
+    LedStats* _stats;                                       /// Estadísticas del led (NULL: sólo el agregado global)
+    LedSeqLock _stats_lock;                                 /// Publicación de las estadísticas del led
+    uint32_t _writes_issued;                                /// Escrituras realizadas en la salida
+    uint32_t _writes_suppressed;                            /// Escrituras evitadas por el registro sombra
+    uint32_t _stat_since;                                   /// Instante de entrada en el estado contabilizado
+    uint8_t _stat;                                          /// Estado contabilizado en las estadísticas (LedStat)
+    uint8_t _type;                                          /// Tipo de led (LedType)
+    uint8_t _action;                                        /// Acción en ejecución del led (LedAction)
+    bool  _debug;                                           /// Canal de depuración
+    bool _ready;                                            /// Eventos reservados en el planificador
+    bool _dither;                                           /// Flag para indicar que el dithering está activo
+    uint16_t _dither_err;                                   /// Error acumulado del modulador sigma-delta
+    uint32_t _dither_us;                                    /// Periodo del tick de dithering (0: periodo del pwm)
+    LedScheduler::Event _ev_dither;                         /// Evento del tick de dithering
+    static LedStats _global_stats;                          /// Estadísticas agregadas de todos los leds
+    static LedSeqLock _global_lock;                         /// Publicación de las estadísticas agregadas
+    const LedGammaTable* _gamma;                            /// Tabla de corrección gamma (NULL: lineal)
     uint32_t _period_ms;                                    /// Periodo del pwm en milisegundos
-    Ticker _tick_ramp;                                      /// Timer para la rampa
-    Ticker _tick_blink;                                     /// Timer para el parpadeo
-    Ticker _tick_duration;                                  /// Timer para la duracin
-    uint32_t _ms_ramp;                                      /// Milisegundos de rampa
-    uint32_t _ms_blink_on;                                  /// Milisegundos de encendido (parpadeo)
-    uint32_t _ms_blink_off;                                 /// Miliegundos de apagado (parpadeo)
-    uint32_t _ms_duration;                                  /// Milisegundos del estado temporal
-    LedStat _bkp_stat;                                      /// Estado backup en modo temporal
-    bool _istemp;                                           /// Flag para indicar si el modo temporal est activo
-    bool  _debug;                                           /// Canal de depuracin
-    uint32_t _blinks[MaxBlinkCount];						/// Lista de parpadeos
-    uint8_t _num_blinks;									/// control del nmero de parpadeos en la lista
-    int8_t _curr_blink;									    /// indicador del parpadeo actual
+    uint32_t _period_us;                                    /// Periodo del pwm en microsegundos
+    LedScheduler* _sched;                                   /// Planificador compartido
+    LedScheduler::Event _ev_ramp;                           /// Evento para la rampa
+    LedScheduler::Event _ev_blink;                          /// Evento para el parpadeo
+    LedScheduler::Event _ev_duration;                       /// Evento de la expiración más próxima entre las capas
+    LedRamp _ramp;                                          /// Rampa en curso
+    const uint16_t* _ramp_table;                            /// Curva de transición de las rampas
+    Layer _layers[MaxLayers];                               /// Capas de prioridad
+    uint8_t _top;                                           /// Capa visible (activa de mayor prioridad)
+    uint32_t _pattern_deadline;                             /// Instante absoluto del último cambio del patrón
+    LedGroup* _group;                                       /// Grupo de parpadeo al que pertenece (NULL: ninguno)
+    Stage _stage[2];                                        /// Doble buffer de cambios preparados
+    volatile uint32_t _stage_ready;                         /// Cambio publicado (0: ninguno, 1..2: buffer + 1)
+    LedState* _state;                                       /// Entrada de la tabla de estados en la que se publica (NULL: ninguna)
+    LedStateTable* _state_table;                            /// Tabla de estados asociada (NULL: ninguna)
   
     
-	/** rampOffCb
-     *  Callback para apagar de forma gradual
+	/** applyOn, applyOff, applyBlink, applyCancelBlinkMode, applyBlinker, applyPlay
+     *  Aplican directamente las operaciones de la API (mismos parámetros que on, off, blink..., con las
+     *  intensidades en Q16)
      */
-    void rampOffCb();
+    void applyOn(uint32_t ms_duration, uint16_t intensity, uint32_t ms_ramp, uint8_t layer = LayerNotification);
+    void applyOff(uint32_t ms_duration, uint16_t intensity, uint32_t ms_ramp, uint8_t layer = LayerNotification);
+    void applyBlink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration, uint16_t intensity_on, uint16_t intensity_off, uint8_t layer);
+    void applyCancelBlinkMode();
+    void applyBlinker(uint32_t ms_blink_on, uint32_t ms_blink_off);
+    void applyPlay(LedPatternHandle pattern, uint32_t ms_duration, uint8_t layer);
+
+
+	/** postPlay
+     *  Encola o aplica una orden OpPlay. El llamante cede una referencia al patrón, que se libera al aplicar
+     *  el comando o si no puede encolarse
+     *  @return 0 OK, -1 Error (cola llena)
+     */
+    int postPlay(LedPatternHandle pattern, uint32_t ms_duration, uint8_t layer);
+
+
+	/** startPattern, stopPattern
+     *  Inician y detienen el patrón de una capa, obteniendo y liberando su referencia en el registro
+     */
+    void startPattern(Layer& l, LedPatternHandle pattern);
+    void stopPattern(Layer& l);
+
+
+	/** apply
+     *  Aplica un comando extraído de la cola del planificador
+     *  @param cmd Comando
+     */
+    void apply(const LedCommand& cmd);
+
+
+	/** postCommand
+     *  Encola un comando si el planificador tiene una cola instalada
+     *  @param cmd Comando
+     *  @param result Recibe 0 OK, -1 Error (cola llena)
+     *  @return true si se ha encolado (o descartado), false si debe aplicarse directamente
+     */
+    bool postCommand(const LedCommand& cmd, int& result);
+
+
+	/** joinGroup
+     *  Detiene la actividad individual del led y lo asocia a un grupo (invocado desde LedGroup)
+     *  @param group Grupo
+     */
+    void joinGroup(LedGroup* group);
+
+
+	/** leaveGroup
+     *  Desasocia el led de su grupo conservando su intensidad actual (invocado desde LedGroup)
+     */
+    void leaveGroup();
+
+
+	/** groupWrite
+     *  Escribe la intensidad indicada por el grupo
+     *  @param value Intensidad Q16
+     */
+    void groupWrite(uint16_t value);
+
+
+	/** startRamp
+     *  Inicia una rampa desde la intensidad actual
+     *  @param target Intensidad final (Q16)
+     *  @param ms_ramp Duración total en milisegundos
+     */
+    void startRamp(uint16_t target, uint32_t ms_ramp);
   
     
-	/** rampOnCb
-     *  Callback para encender de forma gradual
+	/** rampCb
+     *  Callback para ejecutar cada paso de la rampa
      */
-    void rampOnCb();
+    void rampCb();
   
     
 	/** blinkCb
@@ -178,24 +550,182 @@ class Led{
     void blinkCb();
   
     
-	/** temporalCb
-     *  Callback para ejecutar la accin temporal
+	/** expiryCb
+     *  Callback de expiración de las capas temporales. Sólo reevalúa la salida si cambia la capa visible
+     */
+    void expiryCb();
+
+
+	/** selectLayer
+     *  Obtiene la capa destino de una orden. Sin duración es la capa base (descartando las capas temporales
+     *  hasta la prioridad indicada); con duración, la capa indicada, que queda activa hasta su expiración
+     *  @param ms_duration Duración de la orden (0: permanente)
+     *  @param layer Capa de prioridad
+     *  @return Capa destino
      */
-    void temporalCb();
+    Layer& selectLayer(uint32_t ms_duration, uint8_t layer);
+
+
+	/** updateTop
+     *  Recalcula la capa visible y programa el evento de expiración en la más próxima
+     */
+    void updateTop();
+
+
+	/** activate
+     *  Aplica la orden de la capa visible a la salida (O(1))
+     */
+    void activate();
+
+
+	/** stopActivity
+     *  Detiene el parpadeo, el patrón y la rampa en curso
+     */
+    void stopActivity();
+
+
+	/** before
+     *  Compara dos instantes absolutos del planificador (con desbordamiento)
+     *  @return true si a es anterior a b
+     */
+    static bool before(uint32_t a, uint32_t b) { return ((int32_t)(a - b) < 0); }
   
     
 	/** convertIntensity
-     *  Convierte la intensidad 0-100% en un valor de 0-1 teniendo en cuenta la lgica
+     *  Convierte la intensidad 0-100% en un valor Q16. La lógica de activación se aplica al escribir la salida
      *  @param intensity Intensidad 0-100%
-     *  @return Intensidad 0 - 1.0f
+     *  @return Intensidad 0 - IntensityFullScale
      */
-    double convertIntensity(uint8_t intensity);
+    static uint16_t convertIntensity(uint8_t intensity);
 
 
-    /**
-     * Ejecuta la siguiente accin del modo blink
+	/** setup
+     *  Inicializa el estado común a todos los constructores
+     */
+    void setup(PinName32 led, LedType type, uint32_t period_ms, const LedGammaTable* gamma, LedScheduler* sched);
+
+
+	/** Objeto no copiable: la salida reside en el propio objeto */
+    Led(const Led&);
+    Led& operator=(const Led&);
+
+
+	/** attachOutput
+     *  Construye la salida en el almacenamiento interno y deja el led apagado
+     *  @param led GPIO conectado al led
+     *  @param write_fn Función de escritura especializada
+     */
+    void attachOutput(PinName32 led, LedWriteFn write_fn);
+
+
+	/** writeOutput
+     *  Solicita la escritura de la intensidad actual en la salida. Dentro de una pasada del planificador la
+     *  escritura se difiere al final de la pasada, de forma que varios cambios en el mismo instante producen
+     *  una única escritura
+     */
+    void writeOutput();
+
+
+	/** flushOutput
+     *  Escribe la intensidad actual mediante la función especializada para su tipo y lógica de activación,
+     *  salvo que la salida ya tenga ese valor
+     */
+    void flushOutput();
+
+
+	/** patternCb
+     *  Callback del patrón
+     */
+    void patternCb();
+
+
+	/** stepPattern
+     *  Ejecuta instrucciones del patrón de la capa visible hasta la siguiente que consume tiempo
+     */
+    void stepPattern();
+
+
+	/** countCallback, countWrite
+     *  Actualizan las estadísticas del led y las agregadas
+     *  @param type Tipo de callback (LedStats::CallbackType)
+     *  @param issued true: escritura realizada, false: escritura evitada
+     */
+    void countCallback(uint8_t type);
+    void countWrite(bool issued);
+
+
+	/** updateDither
+     *  Planifica o cancela el tick de dithering según la intensidad escrita
+     */
+    void updateDither();
+
+
+	/** ditherCb
+     *  Callback del tick de dithering: reescribe el ancho de pulso con el error acumulado
+     */
+    void ditherCb();
+
+
+	/** updateStat
+     *  Acumula el tiempo del estado anterior si ha cambiado el estado de la capa visible
+     */
+    void updateStat();
+
+
+	/** publishState
+     *  Publica el estado observable del led en su entrada de la LedStateTable asociada (al finalizar cada
+     *  orden y cada callback). Sin tabla no hay nada que publicar: getState lo obtiene bajo demanda
+     */
+    void publishState();
+
+
+	/** fillState
+     *  Obtiene el estado observable del led
+     *  @param s Recibe el estado
+     */
+    void fillState(LedState& s) const;
+
+
+	/** publishStage
+     *  Escribe un cambio en el buffer no publicado y lo publica (contexto del llamante)
+     *  @return 0 OK, -1 la capa visible no parpadea ni ejecuta un patrón (no se publica)
+     */
+    int publishStage(LedPatternHandle pattern, uint32_t ms_blink_on, uint32_t ms_blink_off, uint8_t at);
+
+
+	/** swapStage
+     *  Adopta el cambio publicado si corresponde al punto actual (contexto del timer)
+     *  @param cycle true si el punto actual completa un ciclo o una pasada
+     *  @return true si el cambio ha modificado el tipo de actividad y ya se ha planificado el siguiente
+     *          cambio (el callback no debe continuar), false en otro caso
+     */
+    bool swapStage(bool cycle);
+};
+
+
+
+/** LedT
+ *  Led con el tipo de salida y el nivel lógico fijados en tiempo de compilación.
+ *  Limitación: sólo se fija la función de escritura (ledWrite<Output, Level>). El motor de Led no es una
+ *  plantilla, de forma que LedT ocupa lo mismo que Led (incluido el almacenamiento para cualquier tipo de
+ *  salida) y la escritura se sigue realizando mediante un puntero a función, sin bifurcaciones por tipo ni
+ *  por nivel lógico pero sin expansión en línea.
+ *  Ej: LedT<LedPwmOutput, LedActiveLow> led(pin, 1, &LedGamma<LedCurveCie1931>::table);
+ *  @param Output Política de salida (LedPwmOutput, LedDigitalOutput)
+ *  @param Level Nivel lógico (LedActiveHigh, LedActiveLow)
+ */
+template<class Output, class Level = LedActiveHigh>
+class LedT : public Led{
+  public:
+
+	/** Constructor
+     *  @param led GPIO conectado al led
+     *  @param period_ms Periodo del pwm en milisegundos
+     *  @param gamma Tabla de corrección gamma (NULL: lineal)
+     *  @param sched Planificador compartido (NULL: planificador por defecto)
      */
-    void _executeBlinkMode();
+    LedT(PinName32 led, uint32_t period_ms = 1, const LedGammaTable* gamma = NULL, LedScheduler* sched = NULL) :
+        Led(led, Output::Dimmable? LedDimmableType : LedOnOffType, period_ms, gamma, sched, &ledWrite<Output, Level>) {}
 };
      
 
@@ -0,0 +1,96 @@
+/*
+ * LedBam.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedBam.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedBam::LedBam(PortName port, uint32_t mask, uint8_t bits, uint32_t lsb_us, LedScheduler* sched) : _port(port, (int)mask){
+    _mask = mask;
+    _bits = (bits == 0)? 1 : ((bits > MaxBits)? MaxBits : bits);
+    _lsb_us = (lsb_us == 0)? 1 : lsb_us;
+    _sched = (sched != NULL)? sched : LedScheduler::getDefault();
+    _sched->reserve(1);
+    for(uint8_t k=0;k<MaxBits;k++){
+        _masks[k] = 0;
+        _next[k] = 0;
+    }
+    _on = 0;
+    _slot = 0;
+    _dirty = false;
+    _running = false;
+    _writes = 0;
+    _port.write(0);
+}
+
+
+//------------------------------------------------------------------------------------
+LedBam::~LedBam(){
+    _sched->cancel(&_ev);
+    _sched->release(1);
+    _port.write(0);
+}
+
+
+//------------------------------------------------------------------------------------
+int LedBam::setDuty(uint8_t bit, uint32_t duty){
+    uint32_t pin = (1UL << bit);
+    if(bit >= MaxChannels || (_mask & pin) == 0){
+        return -1;
+    }
+    uint32_t full_scale = (1UL << _bits) - 1;
+    duty = (duty > full_scale)? full_scale : duty;
+    core_util_critical_section_enter();
+    // máscaras precalculadas: el bit k del ciclo de trabajo activa el pin durante el intervalo k
+    for(uint8_t k=0;k<_bits;k++){
+        _next[k] = ((duty >> k) & 1)? (_next[k] | pin) : (_next[k] & ~pin);
+    }
+    _on = (duty != 0)? (_on | pin) : (_on & ~pin);
+    _dirty = true;
+    // la modulación sólo se ejecuta mientras haya algún canal activo
+    if(!_running && _on != 0){
+        _running = true;
+        _slot = _bits - 1;
+        _sched->scheduleAt(&_ev, callback(this, &LedBam::slotCb), _sched->now());
+    }
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void LedBam::slotCb(){
+    uint8_t slot = (_slot >= (_bits - 1))? 0 : (_slot + 1);
+    // inicio de trama: se adoptan las máscaras nuevas (sin cambios a mitad de trama)
+    if(slot == 0 && _dirty){
+        for(uint8_t k=0;k<_bits;k++){
+            _masks[k] = _next[k];
+        }
+        _dirty = false;
+        if(_on == 0){
+            _running = false;
+            _port.write(0);
+            _writes++;
+            return;
+        }
+    }
+    _slot = slot;
+    _port.write((int)_masks[slot]);
+    _writes++;
+    _sched->scheduleAt(&_ev, callback(this, &LedBam::slotCb), _ev.deadline + (_lsb_us << slot));
+}
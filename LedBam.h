@@ -0,0 +1,154 @@
+/*
+ * LedBam.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedBam regula la intensidad de cualquier nº de leds conectados a salidas digitales de un mismo puerto
+ *  mediante modulación por ángulo de bit (BAM). Cada trama se divide en tantos intervalos como bits de
+ *  resolución; el intervalo k dura (lsb_us << k) y durante él cada led está activo si el bit k de su ciclo
+ *  de trabajo vale 1. Las máscaras de puerto de cada bit se precalculan al cambiar la intensidad de un led,
+ *  de forma que cada intervalo se reduce a una única escritura en el puerto. Los intervalos se encadenan
+ *  como eventos de deadline absoluto en el planificador compartido (un único timer).
+ *
+ *  Los leds se crean con el constructor Led(LedBam*, bit, ...) y admiten toda la API de intensidad y rampas.
+ *
+ *  Ej. de uso:
+ *      static LedBam bam(PortA, 0x00F0);       // leds en PA_4..PA_7
+ *      Led red(&bam, 4);
+ *      Led green(&bam, 5, Led::OnIsLowLevel);
+ *      red.on(0, 30, 500);
+ *
+ */
+
+#ifndef __LedBam__H
+#define __LedBam__H
+
+#include "mbed.h"
+#include "PortOut.h"
+#include "LedScheduler.h"
+#include "LedGamma.h"
+#include "LedOutput.h"
+
+
+
+class LedBam{
+  public:
+
+    static const uint8_t MaxBits = 12;                      /// Resolución máxima en bits
+    static const uint8_t MaxChannels = 32;                  /// Nº máximo de canales (anchura del puerto)
+
+
+	/** Constructor
+     *  @param port Puerto
+     *  @param mask Máscara de los bits del puerto conectados a leds
+     *  @param bits Resolución en bits (1..MaxBits)
+     *  @param lsb_us Duración del intervalo del bit menos significativo en microsegundos
+     *  @param sched Planificador compartido (NULL: planificador por defecto)
+     */
+    LedBam(PortName port, uint32_t mask, uint8_t bits = 8, uint32_t lsb_us = 8, LedScheduler* sched = NULL);
+    ~LedBam();
+
+
+	/** setDuty
+     *  Establece el ciclo de trabajo de un canal y recalcula las máscaras de la siguiente trama
+     *  @param bit Bit del puerto
+     *  @param duty Ciclo de trabajo (0 .. (1<<bits)-1)
+	 *  @return 0 OK, -1 Error (bit fuera de la máscara)
+     */
+    int setDuty(uint8_t bit, uint32_t duty);
+
+
+	/** getBits
+     *  @return Resolución en bits
+     */
+    uint8_t getBits() const { return _bits; }
+
+
+	/** getFramePeriod
+     *  @return Duración de una trama en microsegundos
+     */
+    uint32_t getFramePeriod() const { return _lsb_us * ((1UL << _bits) - 1); }
+
+
+	/** getPortWrites
+     *  @return Nº de escrituras en el puerto
+     */
+    uint32_t getPortWrites() const { return _writes; }
+
+
+  private:
+    PortOut _port;                                          /// Puerto de salida
+    uint32_t _mask;                                         /// Bits del puerto gestionados
+    uint8_t _bits;                                          /// Resolución
+    uint32_t _lsb_us;                                       /// Duración del intervalo del bit 0
+    LedScheduler* _sched;                                   /// Planificador compartido
+    LedScheduler::Event _ev;                                /// Evento del siguiente intervalo
+    uint32_t _masks[MaxBits];                               /// Máscaras de la trama en curso
+    uint32_t _next[MaxBits];                                /// Máscaras de la siguiente trama
+    uint32_t _on;                                           /// Canales con ciclo de trabajo no nulo
+    uint8_t _slot;                                          /// Intervalo en curso
+    bool _dirty;                                            /// Flag para indicar que hay máscaras nuevas
+    bool _running;                                          /// Flag para indicar que la modulación está activa
+    uint32_t _writes;                                       /// Nº de escrituras en el puerto
+
+
+	/** slotCb
+     *  Callback de cada intervalo: una única escritura en el puerto
+     */
+    void slotCb();
+};
+
+
+
+/** Canal de un led sobre LedBam (salida alojada en el objeto Led) */
+class LedBamChannel{
+  public:
+    LedBamChannel(LedBam* bam, uint8_t bit) : _bam(bam), _bit(bit) {}
+    ~LedBamChannel(){ _bam->setDuty(_bit, 0); }
+    void write(uint32_t duty){ _bam->setDuty(_bit, duty); }
+    uint8_t getBits() const { return _bam->getBits(); }
+  private:
+    LedBam* _bam;
+    uint8_t _bit;
+};
+
+
+
+/** Política de salida BAM: intensidad con corrección gamma reescalada a la resolución del modulador */
+struct LedBamOutput{
+    typedef LedBamChannel Driver;
+    static const bool Dimmable = true;
+
+    static void init(LedBamChannel& out, uint32_t period_us){
+        (void)out;
+        (void)period_us;
+    }
+
+    template<class Level>
+    static void write(LedBamChannel& out, uint16_t value, const LedGammaTable* gamma, uint32_t period_us, uint16_t* dither){
+        (void)period_us;
+        (void)dither;
+        uint32_t duty = value;
+        uint8_t bits = 16;
+        if(gamma != NULL){
+            duty = gamma->lookup(value);
+            bits = gamma->bits;
+        }
+        duty = Level::apply(duty, (1UL << bits) - 1);
+        uint8_t bam_bits = out.getBits();
+        if(bits >= bam_bits){
+            out.write(duty >> (bits - bam_bits));
+            return;
+        }
+        // tablas de menor resolución que el modulador: reescalado exacto del fondo de escala
+        out.write((duty * ((1UL << bam_bits) - 1)) / ((1UL << bits) - 1));
+    }
+};
+
+
+
+#endif /*__LedBam__H */
+
+/**** END OF FILE ****/
+
@@ -0,0 +1,257 @@
+/*
+ * LedBank.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedBank.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedBank::LedBank(const Arrays& arrays, uint16_t count, uint32_t frame_us){
+    _a = arrays;
+    _count = count;
+    _frame_us = (frame_us == 0)? 1 : frame_us;
+    _now = 0;
+    for(uint16_t i=0;i<_count;i++){
+        _a.level[i] = 0;
+        _a.step[i] = 0;
+        _a.left[i] = 0;
+        _a.out[i] = 0;
+        _a.hi[i] = IntensityFullScale;
+        _a.lo[i] = 0;
+        _a.mode[i] = ModeOff;
+        _a.bkp[i] = ModeOff;
+        _a.seq_len[i] = 0;
+        _a.seq_idx[i] = 0;
+        _a.t_on[i] = 0;
+        _a.t_off[i] = 0;
+        _a.deadline[i] = 0;
+        _a.until[i] = 0;
+        _a.seq[i] = NULL;
+        _a.changed[i] = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void LedBank::on(uint16_t i, uint32_t ms_duration, uint8_t intensity, uint32_t ms_ramp){
+    uint8_t prev = _a.mode[i] & ~ModeTemporal;
+    _a.mode[i] = ModeOn;
+    _a.hi[i] = toQ16(intensity);
+    startTemporal(i, ms_duration, prev);
+    setLevel(i, _a.hi[i], ms_ramp);
+}
+
+
+//------------------------------------------------------------------------------------
+void LedBank::off(uint16_t i, uint32_t ms_duration, uint8_t intensity, uint32_t ms_ramp){
+    uint8_t prev = _a.mode[i] & ~ModeTemporal;
+    _a.mode[i] = ModeOff;
+    _a.lo[i] = toQ16(intensity);
+    startTemporal(i, ms_duration, prev);
+    setLevel(i, _a.lo[i], ms_ramp);
+}
+
+
+//------------------------------------------------------------------------------------
+void LedBank::blink(uint16_t i, uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration, uint8_t intensity_on, uint8_t intensity_off){
+    // si no hay temporizaciones de On y Off, no permite la ejecución
+    if(ms_blink_on == 0 && ms_blink_off == 0){
+        return;
+    }
+    uint8_t prev = _a.mode[i] & ~ModeTemporal;
+    _a.mode[i] = ModeBlink;
+    _a.t_on[i] = ms_blink_on * 1000;
+    _a.t_off[i] = ms_blink_off * 1000;
+    _a.hi[i] = toQ16(intensity_on);
+    _a.lo[i] = toQ16(intensity_off);
+    startTemporal(i, ms_duration, prev);
+    // fase de encendido; el siguiente cambio se encadena con este instante
+    _a.seq_idx[i] = 0;
+    _a.deadline[i] = _now + _a.t_on[i];
+    setLevel(i, _a.hi[i], 0);
+}
+
+
+//------------------------------------------------------------------------------------
+int LedBank::setBlinkMode(uint16_t i, const uint32_t blinks[], uint8_t count){
+    if(count > MaxBlinkCount){
+        return -1;
+    }
+    // una lista vacía desactiva el modo blink
+    if(count == 0 || blinks == NULL){
+        cancelBlinkMode(i);
+        return 0;
+    }
+    _a.seq[i] = blinks;
+    _a.seq_len[i] = count;
+    _a.mode[i] = ModeBlinkMode;
+    _a.hi[i] = IntensityFullScale;
+    _a.lo[i] = 0;
+    _a.seq_idx[i] = count - 1;
+    _a.deadline[i] = _now;
+    nextBlinkMode(i);
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedBank::cancelBlinkMode(uint16_t i){
+    _a.seq_len[i] = 0;
+    _a.seq[i] = NULL;
+    // un estado temporal no debe restaurar el modo blink sin lista
+    if(_a.bkp[i] == ModeBlinkMode){
+        _a.bkp[i] = ModeOff;
+    }
+    off(i);
+}
+
+
+//------------------------------------------------------------------------------------
+uint16_t LedBank::update(uint32_t now_us){
+    _now = now_us;
+    uint32_t* level = _a.level;
+    const int32_t* step = _a.step;
+    uint16_t* left = _a.left;
+
+    // kernel de rampas: misma operación para todos los leds, sin bifurcaciones
+    for(uint16_t i=0;i<_count;i++){
+        uint32_t active = (left[i] != 0)? 1 : 0;
+        level[i] += (uint32_t)step[i] & (0U - active);
+        left[i] -= (uint16_t)active;
+    }
+
+    // vencimientos: sólo los leds con parpadeo, modo blink o estado temporal
+    const uint8_t* mode = _a.mode;
+    for(uint16_t i=0;i<_count;i++){
+        if(mode[i] > ModeOn){
+            expire(i, now_us);
+        }
+    }
+
+    // detección de cambios
+    uint16_t n = 0;
+    uint16_t* out = _a.out;
+    for(uint16_t i=0;i<_count;i++){
+        uint16_t v = (uint16_t)(level[i] >> 16);
+        if(v != out[i]){
+            out[i] = v;
+            _a.changed[n++] = i;
+        }
+    }
+    return n;
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void LedBank::setLevel(uint16_t i, uint16_t target, uint32_t ms_ramp){
+    uint32_t end = (uint32_t)target << 16;
+    uint32_t frames = (ms_ramp * 1000) / _frame_us;
+    frames = (frames > 0xFFFF)? 0xFFFF : frames;
+    if(frames <= 1){
+        _a.level[i] = end;
+        _a.step[i] = 0;
+        _a.left[i] = 0;
+        return;
+    }
+    int64_t delta = (int64_t)end - (int64_t)_a.level[i];
+    int32_t step = (int32_t)(delta / (int64_t)frames);
+    // el inicio se ajusta (menos de una cuenta Q16) para que la última trama llegue exactamente al destino
+    _a.level[i] = (uint32_t)((int64_t)end - ((int64_t)step * frames));
+    _a.step[i] = step;
+    _a.left[i] = (uint16_t)frames;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedBank::startTemporal(uint16_t i, uint32_t ms_duration, uint8_t prev){
+    if(ms_duration == 0){
+        return;
+    }
+    _a.bkp[i] = prev;
+    _a.until[i] = _now + (ms_duration * 1000);
+    _a.mode[i] |= ModeTemporal;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedBank::nextBlinkMode(uint16_t i){
+    if(_a.seq_len[i] == 0 || _a.seq[i] == NULL){
+        _a.mode[i] = ModeOff;
+        setLevel(i, _a.lo[i], 0);
+        return;
+    }
+    uint8_t idx = _a.seq_idx[i];
+    idx = (idx >= (_a.seq_len[i] - 1))? 0 : (idx + 1);
+    _a.seq_idx[i] = idx;
+    // si es par correponde un ON
+    setLevel(i, (idx & 1)? _a.lo[i] : _a.hi[i], 0);
+    _a.deadline[i] += (_a.seq[i][idx] * 1000);
+}
+
+
+//------------------------------------------------------------------------------------
+void LedBank::expire(uint16_t i, uint32_t now_us){
+    // fin del estado temporal: se restaura el modo anterior
+    if((_a.mode[i] & ModeTemporal) && expired(_a.until[i], now_us)){
+        _a.mode[i] = _a.bkp[i];
+        switch(_a.mode[i]){
+            case ModeOn:
+                setLevel(i, _a.hi[i], 0);
+                return;
+            case ModeBlink:
+                _a.seq_idx[i] = 0;
+                _a.deadline[i] = now_us + _a.t_on[i];
+                setLevel(i, _a.hi[i], 0);
+                return;
+            case ModeBlinkMode:
+                _a.deadline[i] = now_us;
+                nextBlinkMode(i);
+                return;
+            case ModeOff:
+            default:
+                setLevel(i, _a.lo[i], 0);
+                return;
+        }
+    }
+    uint8_t m = _a.mode[i] & ~ModeTemporal;
+    if(m == ModeBlink){
+        // deadlines encadenados: la latencia de la trama no se acumula
+        if(expired(_a.deadline[i], now_us)){
+            _a.seq_idx[i] ^= 1;
+            if(_a.seq_idx[i] & 1){
+                _a.deadline[i] += _a.t_off[i];
+                setLevel(i, _a.lo[i], 0);
+            }
+            else{
+                _a.deadline[i] += _a.t_on[i];
+                setLevel(i, _a.hi[i], 0);
+            }
+        }
+    }
+    else if(m == ModeBlinkMode){
+        if(expired(_a.deadline[i], now_us)){
+            nextBlinkMode(i);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+uint16_t LedBank::toQ16(uint8_t intensity){
+    intensity = (intensity > 100)? 100 : intensity;
+    return (uint16_t)((((uint32_t)intensity * IntensityFullScale) + 50) / 100);
+}
@@ -0,0 +1,200 @@
+/*
+ * LedBank.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedBank gestiona el estado de N leds en arrays contiguos (struct of arrays) en lugar de N objetos Led.
+ *  La API reproduce la semántica de Led (on, off, blink, setBlinkMode, con duración temporal y rampas), pero
+ *  el avance del estado se realiza por tramas: en cada trama, update() recorre los arrays con un único
+ *  kernel que avanza todas las rampas (sin bifurcaciones, apto para vectorización), atiende los vencimientos
+ *  de parpadeos y estados temporales y genera la lista de leds cuya intensidad ha cambiado. La escritura de
+ *  las salidas queda a cargo de la aplicación (pwm, BAM, drivers serie...).
+ *
+ *  Ej. de uso:
+ *      static LedBankT<64> panel(1000);        // tramas de 1ms
+ *      ...
+ *      panel.blink(3, 250, 250);
+ *      panel.on(7, 0, 50, 500);
+ *      // en cada trama:
+ *      uint16_t n = panel.update(now_us);
+ *      for(uint16_t k=0;k<n;k++){
+ *          uint16_t i = panel.changed()[k];
+ *          write_duty(i, panel.value(i));
+ *      }
+ *
+ */
+
+#ifndef __LedBank__H
+#define __LedBank__H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+
+class LedBank{
+  public:
+
+    /** Arrays de estado (cada uno de count elementos) */
+    struct Arrays{
+        uint32_t* level;                                    /// Intensidad actual (Q16.16)
+        int32_t* step;                                      /// Incremento de la rampa por trama (Q16.16)
+        uint16_t* left;                                     /// Tramas restantes de la rampa
+        uint16_t* out;                                      /// Última intensidad emitida (Q16)
+        uint16_t* hi;                                       /// Intensidad de encendido (Q16)
+        uint16_t* lo;                                       /// Intensidad de apagado (Q16)
+        uint8_t* mode;                                      /// Modo (Mode)
+        uint8_t* bkp;                                       /// Modo a restaurar tras un estado temporal
+        uint8_t* seq_len;                                   /// Nº de tiempos del modo blink
+        uint8_t* seq_idx;                                   /// Tiempo actual del modo blink
+        uint32_t* t_on;                                     /// Tiempo de encendido del parpadeo (us)
+        uint32_t* t_off;                                    /// Tiempo de apagado del parpadeo (us)
+        uint32_t* deadline;                                 /// Siguiente cambio del parpadeo o del modo blink
+        uint32_t* until;                                    /// Fin del estado temporal
+        const uint32_t** seq;                               /// Lista de tiempos del modo blink (ms)
+        uint16_t* changed;                                  /// Índices de los leds modificados en la última trama
+    };
+
+
+	/** Constructor
+     *  @param arrays Arrays de estado
+     *  @param count Nº de leds
+     *  @param frame_us Duración de una trama en microsegundos
+     */
+    LedBank(const Arrays& arrays, uint16_t count, uint32_t frame_us);
+
+
+	/** on, off, blink, setBlinkMode, cancelBlinkMode
+     *  Misma semántica que los métodos de Led, aplicada al led i del banco. setBlinkMode no copia la lista
+     *  de tiempos: debe permanecer válida mientras el modo esté activo. setBlinkMode con una lista vacía
+     *  equivale a cancelBlinkMode
+     *  @param i Índice del led
+     */
+    void on(uint16_t i, uint32_t ms_duration = 0, uint8_t intensity = 100, uint32_t ms_ramp = 0);
+    void off(uint16_t i, uint32_t ms_duration = 0, uint8_t intensity = 0, uint32_t ms_ramp = 0);
+    void blink(uint16_t i, uint32_t ms_blink_on, uint32_t ms_blink_off, uint32_t ms_duration = 0, uint8_t intensity_on = 100, uint8_t intensity_off = 0);
+    int setBlinkMode(uint16_t i, const uint32_t blinks[], uint8_t count);
+    void cancelBlinkMode(uint16_t i);
+
+
+	/** update
+     *  Avanza una trama todos los leds del banco
+     *  @param now_us Instante de la trama en microsegundos
+     *  @return Nº de leds cuya intensidad ha cambiado (ver changed())
+     */
+    uint16_t update(uint32_t now_us);
+
+
+	/** changed
+     *  @return Índices de los leds modificados en la última trama
+     */
+    const uint16_t* changed() const { return _a.changed; }
+
+
+	/** value
+     *  @param i Índice del led
+     *  @return Intensidad actual (Q16)
+     */
+    uint16_t value(uint16_t i) const { return _a.out[i]; }
+
+
+	/** size
+     *  @return Nº de leds
+     */
+    uint16_t size() const { return _count; }
+
+
+  private:
+    enum Mode{
+        ModeOff,
+        ModeOn,
+        ModeBlink,
+        ModeBlinkMode,
+        ModeTemporal = 0x80,                                /// Flag de estado temporal
+    };
+
+    static const uint8_t MaxBlinkCount = 16;                /// Máximo nº de tiempos del modo blink
+    static const uint16_t IntensityFullScale = 0xFFFF;      /// Intensidad máxima (Q16)
+
+    Arrays _a;                                              /// Arrays de estado
+    uint16_t _count;                                        /// Nº de leds
+    uint32_t _frame_us;                                     /// Duración de una trama
+    uint32_t _now;                                          /// Instante de la última trama
+
+
+	/** setLevel
+     *  Fija la intensidad de un led, instantáneamente o con una rampa
+     */
+    void setLevel(uint16_t i, uint16_t target, uint32_t ms_ramp);
+
+
+	/** startTemporal
+     *  Inicia el estado temporal de un led si ms_duration != 0
+     *  @param prev Modo a restaurar al finalizar
+     */
+    void startTemporal(uint16_t i, uint32_t ms_duration, uint8_t prev);
+
+
+	/** nextBlinkMode
+     *  Ejecuta el siguiente tiempo del modo blink
+     */
+    void nextBlinkMode(uint16_t i);
+
+
+	/** expire
+     *  Atiende los vencimientos de un led (parpadeo, modo blink, estado temporal)
+     */
+    void expire(uint16_t i, uint32_t now_us);
+
+
+	/** toQ16
+     *  Convierte la intensidad 0-100% en un valor Q16
+     */
+    static uint16_t toQ16(uint8_t intensity);
+
+
+	/** Comparación de instantes teniendo en cuenta el desbordamiento */
+    static bool expired(uint32_t deadline, uint32_t now) { return ((int32_t)(now - deadline) >= 0); }
+};
+
+
+
+/** LedBankT
+ *  Banco con los arrays de estado alojados en el propio objeto
+ *  @param N Nº de leds
+ */
+template<uint16_t N>
+class LedBankT : public LedBank{
+  public:
+    LedBankT(uint32_t frame_us = 1000) : LedBank(arrays(), N, frame_us) {}
+  private:
+    uint32_t _level[N];
+    int32_t _step[N];
+    uint16_t _left[N];
+    uint16_t _out[N];
+    uint16_t _hi[N];
+    uint16_t _lo[N];
+    uint8_t _mode[N];
+    uint8_t _bkp[N];
+    uint8_t _seq_len[N];
+    uint8_t _seq_idx[N];
+    uint32_t _t_on[N];
+    uint32_t _t_off[N];
+    uint32_t _deadline[N];
+    uint32_t _until[N];
+    const uint32_t* _seq[N];
+    uint16_t _changed[N];
+
+    Arrays arrays(){
+        Arrays a = { _level, _step, _left, _out, _hi, _lo, _mode, _bkp, _seq_len, _seq_idx, _t_on, _t_off, _deadline, _until, _seq, _changed };
+        return a;
+    }
+};
+
+
+
+#endif /*__LedBank__H */
+
+/**** END OF FILE ****/
+
@@ -0,0 +1,86 @@
+/*
+ * LedCommandQueue.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedCommandQueue.h"
+#include "Led.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedCommandQueue::LedCommandQueue(Slot* storage, uint16_t size){
+    uint32_t n = 1;
+    while((n << 1) <= size){
+        n <<= 1;
+    }
+    _slots = storage;
+    _mask = n - 1;
+    _tail = 0;
+    _head = 0;
+    _dropped = 0;
+    // cada posición espera al productor con su mismo índice
+    for(uint32_t i=0;i<n;i++){
+        _slots[i].seq = i;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+int LedCommandQueue::post(const LedCommand& cmd){
+    uint32_t pos = core_util_atomic_load_u32(&_tail);
+    for(;;){
+        Slot* slot = &_slots[pos & _mask];
+        int32_t diff = (int32_t)(core_util_atomic_load_u32(&slot->seq) - pos);
+        // posición libre: se reserva avanzando el índice de escritura
+        if(diff == 0){
+            if(core_util_atomic_cas_u32(&_tail, &pos, pos + 1)){
+                slot->cmd = cmd;
+                // publica el comando para el consumidor
+                core_util_atomic_store_u32(&slot->seq, pos + 1);
+                return 0;
+            }
+            // otro productor ha reservado la posición: pos contiene el nuevo índice
+        }
+        // la posición aún no ha sido liberada por el consumidor: cola llena
+        else if(diff < 0){
+            core_util_atomic_incr_u32(&_dropped, 1);
+            return -1;
+        }
+        else{
+            pos = core_util_atomic_load_u32(&_tail);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedCommandQueue::pop(LedCommand& cmd){
+    Slot* slot = &_slots[_head & _mask];
+    if(core_util_atomic_load_u32(&slot->seq) != (_head + 1)){
+        return false;
+    }
+    cmd = slot->cmd;
+    // libera la posición para la siguiente vuelta de los productores
+    core_util_atomic_store_u32(&slot->seq, _head + _mask + 1);
+    _head++;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------------
+uint16_t LedCommandQueue::drain(){
+    LedCommand cmd;
+    uint16_t count = 0;
+    while(count <= _mask && pop(cmd)){
+        cmd.led->apply(cmd);
+        count++;
+    }
+    return count;
+}
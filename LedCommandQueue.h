@@ -0,0 +1,149 @@
+/*
+ * LedCommandQueue.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Cola de comandos sin bloqueos (MPSC) entre los hilos de la aplicación y el contexto del timer. Cuando un
+ *  planificador tiene una cola instalada (LedScheduler::attachQueue), las llamadas on(), off(), blink(),
+ *  setBlinkMode(), cancelBlinkMode(), updateBlinker() y play() de sus leds no modifican el estado del led:
+ *  codifican un comando compacto, lo insertan en la cola y despiertan al planificador, que aplica todos los
+ *  comandos pendientes en su siguiente pasada. De este modo el estado de cada led sólo se modifica desde el
+ *  contexto del timer.
+ *
+ *  La cola es un buffer circular de tamaño potencia de 2 con un nº de secuencia por posición: varios
+ *  productores reservan posiciones mediante CAS sobre el índice de escritura y un único consumidor (el
+ *  planificador) las libera. Ningún productor se bloquea; si la cola está llena, el comando se descarta y la
+ *  orden del led devuelve -1.
+ *
+ *  Ej. de uso:
+ *      static LedSchedulerT<32> sched;
+ *      static LedCommandQueueT<16> queue;
+ *      ...
+ *      sched.attachQueue(&queue);
+ *      Led led(PA_8, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+ *      led.on(0, 50);      // se aplica en el contexto del timer
+ *
+ */
+
+#ifndef __LedCommandQueue__H
+#define __LedCommandQueue__H
+
+#include "mbed.h"
+
+class Led;
+struct LedPattern;
+
+
+/** Comando compacto de la API de Led */
+struct LedCommand{
+    enum Op{
+        OpOn,                                               /// on(duration, intensity, ramp)
+        OpOff,                                              /// off(duration, intensity, ramp)
+        OpBlink,                                            /// blink(on, off, duration, intensity_on, intensity_off)
+        OpCancelBlinkMode,                                  /// cancelBlinkMode()
+        OpUpdateBlinker,                                    /// updateBlinker(on, off)
+        OpPlay,                                             /// play(pattern)
+    };
+
+    Led* led;                                               /// Led destino
+    uint8_t op;                                             /// Operación (Op)
+    uint8_t layer;                                          /// Capa (on, off, blink, play)
+    uint16_t level0;                                        /// Intensidad Q16 (on/off) o intensidad de encendido (blink)
+    uint16_t level1;                                        /// Intensidad Q16 de apagado (blink)
+    uint32_t arg0;                                          /// Duración (on/off, play) o tiempo de encendido (blink)
+    uint32_t arg1;                                          /// Rampa (on/off) o tiempo de apagado (blink)
+    union{
+        uint32_t arg2;                                      /// Duración (blink)
+        const LedPattern* pattern;                          /// Patrón (play, setBlinkMode)
+    };
+
+    LedCommand() = default;
+    LedCommand(Led* l, Op o, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0, uint16_t l0 = 0, uint16_t l1 = 0, uint8_t ly = 0) :
+        led(l), op((uint8_t)o), layer(ly), level0(l0), level1(l1), arg0(a0), arg1(a1), pattern(NULL) { arg2 = a2; }
+};
+
+
+
+class LedCommandQueue{
+  public:
+
+    /** Posición de la cola */
+    struct Slot{
+        volatile uint32_t seq;                              /// Nº de secuencia de la posición
+        LedCommand cmd;                                     /// Comando almacenado
+    };
+
+
+	/** Constructor
+     *  @param storage Array de size posiciones
+     *  @param size Nº de posiciones. Si no es potencia de 2 se utiliza la potencia de 2 inmediatamente inferior
+     */
+    LedCommandQueue(Slot* storage, uint16_t size);
+
+
+	/** post
+     *  Inserta un comando. Puede invocarse desde varios hilos simultáneamente; nunca se bloquea
+     *  @param cmd Comando
+	 *  @return 0 OK, -1 Error (cola llena, el comando se descarta)
+     */
+    int post(const LedCommand& cmd);
+
+
+	/** pop
+     *  Extrae el comando más antiguo (sólo desde el consumidor)
+     *  @param cmd Recibe el comando
+     *  @return true si se ha extraído un comando, false si la cola está vacía
+     */
+    bool pop(LedCommand& cmd);
+
+
+	/** drain
+     *  Aplica los comandos pendientes sobre sus leds (sólo desde el consumidor). Como máximo procesa tantos
+     *  comandos como posiciones tiene la cola, para acotar el tiempo en la interrupción
+     *  @return Nº de comandos aplicados
+     */
+    uint16_t drain();
+
+
+	/** capacity
+     *  @return Nº de posiciones de la cola
+     */
+    uint16_t capacity() const { return (uint16_t)(_mask + 1); }
+
+
+	/** getDropped
+     *  @return Nº de comandos descartados por cola llena
+     */
+    uint32_t getDropped() const { return _dropped; }
+
+
+  private:
+    Slot* _slots;                                           /// Posiciones de la cola
+    uint32_t _mask;                                         /// Máscara de índice (tamaño - 1)
+    volatile uint32_t _tail;                                /// Índice de escritura (productores)
+    uint32_t _head;                                         /// Índice de lectura (consumidor)
+    volatile uint32_t _dropped;                             /// Nº de comandos descartados
+};
+
+
+
+/** LedCommandQueueT
+ *  Cola con las posiciones alojadas en el propio objeto
+ *  @param Size Nº de posiciones (potencia de 2)
+ */
+template<uint16_t Size>
+class LedCommandQueueT : public LedCommandQueue{
+    static_assert(Size > 0 && (Size & (Size - 1)) == 0, "LedCommandQueueT: el tamaño debe ser potencia de 2");
+  public:
+    LedCommandQueueT() : LedCommandQueue(_storage, Size) {}
+  private:
+    Slot _storage[Size];                                    /// Almacenamiento de la cola
+};
+
+
+
+#endif /*__LedCommandQueue__H */
+
+/**** END OF FILE ****/
+
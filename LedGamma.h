@@ -0,0 +1,109 @@
+/*
+ * LedGamma.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Tablas de corrección gamma / luminosidad percibida generadas en tiempo de compilación. Cada tabla tiene
+ *  LedGammaSize entradas equiespaciadas en la intensidad Q16 y devuelve el ciclo de trabajo con la
+ *  profundidad de bits seleccionada; los bits bajos de la intensidad interpolan entre entradas vecinas. Las tablas son constexpr, residen en flash y no requieren
+ *  inicialización en tiempo de ejecución.
+ *
+ *  Ej. de uso:
+ *      Led led(pin, Led::LedDimmableType, Led::OnIsHighLevel, 1, &LedGamma<LedCurveCie1931>::table);
+ *
+ */
+
+#ifndef __LedGamma__H
+#define __LedGamma__H
+
+#include <stdint.h>
+
+
+/** Curvas de corrección disponibles */
+enum LedCurve{
+    LedCurveLinear,         /// y = x
+    LedCurveQuadratic,      /// y = x^2 (aprox. gamma 2.0)
+    LedCurveCubic,          /// y = x^3 (aprox. gamma 3.0)
+    LedCurveCie1931,        /// Luminosidad percibida CIE 1931 (L*)
+};
+
+
+/** Nº de entradas de las tablas */
+static const uint16_t LedGammaSize = 256;
+
+
+/** Descriptor de tabla utilizado por los objetos Led */
+struct LedGammaTable{
+    const uint16_t* lut;    /// Tabla de LedGammaSize entradas
+    uint8_t bits;           /// Profundidad de bits de la salida (valor máximo (1<<bits)-1)
+
+	/** lookup
+     *  Corrección de una intensidad de 16 bits: interpolación lineal entre las dos entradas vecinas con los
+     *  bits bajos, de forma que las intensidades de 16 bits no se reducen a los 8 bits del índice
+     *  @param value Intensidad Q16
+     *  @return Ciclo de trabajo con la profundidad de bits de la tabla
+     */
+    uint32_t lookup(uint16_t value) const {
+        // posición en la tabla en Q16: value * (LedGammaSize - 1) / 0xFFFF, sin división
+        uint32_t pos = ((uint32_t)value * (LedGammaSize - 1)) + (value >> 8);
+        uint32_t idx = pos >> 16;
+        if(idx >= (uint32_t)(LedGammaSize - 1)){
+            return lut[LedGammaSize - 1];
+        }
+        int32_t d0 = lut[idx];
+        int32_t d1 = lut[idx + 1];
+        // fracción en Q15: el producto cabe en 32 bits con cualquier diferencia entre entradas
+        return (uint32_t)(d0 + (((d1 - d0) * (int32_t)((pos & 0xFFFF) >> 1)) >> 15));
+    }
+};
+
+
+/** Evaluación de las curvas (sólo se utiliza en tiempo de compilación) */
+constexpr double ledCie1931(double l){
+    return (l <= 8.0)? (l / 903.3) : (((l + 16.0) / 116.0) * ((l + 16.0) / 116.0) * ((l + 16.0) / 116.0));
+}
+
+constexpr double ledCurveEval(LedCurve curve, double x){
+    return (curve == LedCurveLinear)? x :
+           (curve == LedCurveQuadratic)? (x * x) :
+           (curve == LedCurveCubic)? (x * x * x) :
+           ledCie1931(x * 100.0);
+}
+
+constexpr uint16_t ledGammaValue(LedCurve curve, uint8_t bits, uint16_t i){
+    return (uint16_t)((ledCurveEval(curve, (double)i / (LedGammaSize - 1)) * (double)((1UL << bits) - 1)) + 0.5);
+}
+
+
+/** Secuencia de índices 0..N-1 para la generación de tablas */
+template<uint16_t... I> struct LedIndexSeq {};
+template<uint16_t N, uint16_t... I> struct LedMakeSeq : LedMakeSeq<N - 1, N - 1, I...> {};
+template<uint16_t... I> struct LedMakeSeq<0, I...> { typedef LedIndexSeq<I...> type; };
+
+
+/** Tabla de corrección para una curva y profundidad de bits
+ *  @param Curve Curva de corrección
+ *  @param Bits Profundidad de bits de la salida (1..16)
+ */
+template<LedCurve Curve, uint8_t Bits = 16, class Seq = typename LedMakeSeq<LedGammaSize>::type>
+struct LedGamma;
+
+template<LedCurve Curve, uint8_t Bits, uint16_t... I>
+struct LedGamma<Curve, Bits, LedIndexSeq<I...> >{
+    static_assert(Bits > 0 && Bits <= 16, "LedGamma: profundidad de bits fuera de rango");
+    static constexpr uint16_t lut[sizeof...(I)] = { ledGammaValue(Curve, Bits, I)... };
+    static constexpr LedGammaTable table = { lut, Bits };
+};
+
+template<LedCurve Curve, uint8_t Bits, uint16_t... I>
+constexpr uint16_t LedGamma<Curve, Bits, LedIndexSeq<I...> >::lut[sizeof...(I)];
+
+template<LedCurve Curve, uint8_t Bits, uint16_t... I>
+constexpr LedGammaTable LedGamma<Curve, Bits, LedIndexSeq<I...> >::table;
+
+
+#endif /*__LedGamma__H */
+
+/**** END OF FILE ****/
+
@@ -0,0 +1,182 @@
+/*
+ * LedGroup.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedGroup.h"
+#include "Led.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedGroup::LedGroup(Member* storage, uint16_t max_members, LedScheduler* sched){
+    _sched = (sched != NULL)? sched : LedScheduler::getDefault();
+    _sched->reserve(1);
+    _members = storage;
+    _max_members = max_members;
+    _count = 0;
+    _epoch = 0;
+    _on_us = 0;
+    _off_us = 0;
+    _max_intensity = Led::convertIntensity(100);
+    _min_intensity = 0;
+    _running = false;
+}
+
+
+//------------------------------------------------------------------------------------
+LedGroup::~LedGroup(){
+    _sched->cancel(&_ev);
+    _sched->release(1);
+    while(_count > 0){
+        leave(_members[_count - 1].led);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+int LedGroup::blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint8_t intensity_on, uint8_t intensity_off){
+    // si no hay temporizaciones de On y Off, no permite la ejecución
+    if(ms_blink_on == 0 && ms_blink_off == 0){
+        return -1;
+    }
+    core_util_critical_section_enter();
+    _on_us = ms_blink_on * 1000;
+    _off_us = ms_blink_off * 1000;
+    _max_intensity = Led::convertIntensity(intensity_on);
+    _min_intensity = Led::convertIntensity(intensity_off);
+    _epoch = _sched->now();
+    _running = true;
+    for(uint16_t i=0;i<_count;i++){
+        sync(_members[i], _epoch);
+    }
+    rearm();
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedGroup::stop(){
+    core_util_critical_section_enter();
+    _running = false;
+    _sched->cancel(&_ev);
+    for(uint16_t i=0;i<_count;i++){
+        _members[i].on = false;
+        _members[i].led->groupWrite(_min_intensity);
+    }
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+int LedGroup::join(Led* led, uint32_t ms_offset){
+    if(led->_group == this){
+        return 0;
+    }
+    if(_count >= _max_members){
+        return -1;
+    }
+    // abandona su grupo anterior y detiene su actividad individual
+    led->joinGroup(this);
+    core_util_critical_section_enter();
+    Member& m = _members[_count];
+    m.led = led;
+    m.offset_us = ms_offset * 1000;
+    m.on = false;
+    _count++;
+    if(_running){
+        // el nuevo miembro toma la fase que le corresponde respecto al epoch común
+        sync(m, _sched->now());
+        rearm();
+    }
+    else{
+        led->groupWrite(_min_intensity);
+    }
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int LedGroup::leave(Led* led){
+    core_util_critical_section_enter();
+    for(uint16_t i=0;i<_count;i++){
+        if(_members[i].led == led){
+            _members[i] = _members[_count - 1];
+            _count--;
+            led->leaveGroup();
+            if(_count == 0){
+                _sched->cancel(&_ev);
+            }
+            core_util_critical_section_exit();
+            return 0;
+        }
+    }
+    core_util_critical_section_exit();
+    return -1;
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void LedGroup::sync(Member& m, uint32_t t){
+    uint32_t period = _on_us + _off_us;
+    // fase del miembro en el ciclo (la división se realiza al unirse o al iniciar el parpadeo)
+    uint32_t phase = ((t - _epoch) % period) + period - (m.offset_us % period);
+    phase = (phase >= period)? (phase - period) : phase;
+    m.on = (phase < _on_us);
+    m.next = t + (m.on? (_on_us - phase) : (period - phase));
+    m.led->groupWrite(m.on? _max_intensity : _min_intensity);
+}
+
+
+//------------------------------------------------------------------------------------
+void LedGroup::rearm(){
+    // con un tiempo nulo el estado es constante: no hay cambios que planificar
+    if(!_running || _count == 0 || _on_us == 0 || _off_us == 0){
+        _sched->cancel(&_ev);
+        return;
+    }
+    uint32_t next = _members[0].next;
+    for(uint16_t i=1;i<_count;i++){
+        if(before(_members[i].next, next)){
+            next = _members[i].next;
+        }
+    }
+    if(!LedScheduler::isScheduled(&_ev) || _ev.deadline != next){
+        _sched->scheduleAt(&_ev, callback(this, &LedGroup::edgeCb), next);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void LedGroup::edgeCb(){
+    uint32_t t = _ev.deadline;
+    uint32_t period = _on_us + _off_us;
+    // el epoch avanza por ciclos completos para que t - epoch no desborde
+    while((t - _epoch) >= period){
+        _epoch += period;
+    }
+    // todos los miembros que cambian en este instante se atienden en la misma pasada
+    for(uint16_t i=0;i<_count;i++){
+        Member& m = _members[i];
+        if(!before(t, m.next)){
+            m.on = !m.on;
+            m.next += (m.on? _on_us : _off_us);
+            m.led->groupWrite(m.on? _max_intensity : _min_intensity);
+        }
+    }
+    rearm();
+}
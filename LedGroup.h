@@ -0,0 +1,160 @@
+/*
+ * LedGroup.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedGroup permite que varios leds parpadeen sobre una base de tiempos común. El grupo mantiene un único
+ *  instante de referencia (epoch) y un único evento en el planificador: todos los cambios que coinciden en el
+ *  mismo instante se ejecutan en una sola pasada, de forma que el nº de interrupciones por flanco no depende
+ *  del nº de leds. Los miembros pueden unirse o abandonar el grupo en cualquier momento sin perder la fase,
+ *  y cada uno puede tener un desfase propio respecto al epoch.
+ *
+ *  Un led que recibe una orden individual (on, off, blink, setBlinkMode...) abandona el grupo.
+ *
+ *  Ej. de uso:
+ *      static LedGroupT<4> group;
+ *      ...
+ *      group.join(&red);
+ *      group.join(&green);
+ *      group.join(&white, 125);    // desfase de 125ms
+ *      group.blink(250, 250);
+ *
+ */
+
+#ifndef __LedGroup__H
+#define __LedGroup__H
+
+#include "mbed.h"
+#include "LedScheduler.h"
+
+class Led;
+
+
+
+class LedGroup{
+  public:
+
+    /** Miembro del grupo */
+    struct Member{
+        Led* led;                                           /// Led
+        uint32_t offset_us;                                 /// Desfase respecto al epoch
+        uint32_t next;                                      /// Instante absoluto de su siguiente cambio
+        bool on;                                            /// Estado actual
+    };
+
+
+	/** Constructor
+     *  @param storage Array de max_members miembros
+     *  @param max_members Nº máximo de miembros
+     *  @param sched Planificador compartido (NULL: planificador por defecto). Debe ser el mismo que el de los leds
+     */
+    LedGroup(Member* storage, uint16_t max_members, LedScheduler* sched = NULL);
+    ~LedGroup();
+
+
+	/** blink
+     *  Inicia el parpadeo del grupo. El epoch se fija en el instante actual
+     *	@param ms_blink_on Tiempo de encendido en ms
+	 *	@param ms_blink_off Tiempo de apagado en ms
+	 *  @param intensity_on Intensidad de encendido en porcentaje 0-100%
+	 *  @param intensity_off Intensidad de apagado en porcentaje 0-100%
+	 *  @return 0 OK, -1 Error (temporizaciones nulas)
+     */
+    int blink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint8_t intensity_on = 100, uint8_t intensity_off = 0);
+
+
+	/** stop
+     *  Detiene el parpadeo y deja los miembros en su intensidad de apagado
+     */
+    void stop();
+
+
+	/** join
+     *  Añade un led al grupo. Si el grupo está parpadeando, el led toma inmediatamente el estado que le
+     *  corresponde por su fase
+     *  @param led Led (con el mismo planificador que el grupo)
+     *  @param ms_offset Desfase respecto al epoch en ms
+	 *  @return 0 OK, -1 Error (grupo lleno)
+     */
+    int join(Led* led, uint32_t ms_offset = 0);
+
+
+	/** leave
+     *  Elimina un led del grupo. El led conserva su última intensidad
+     *  @param led Led
+	 *  @return 0 OK, -1 Error (no es miembro)
+     */
+    int leave(Led* led);
+
+
+	/** size
+     *  @return Nº de miembros
+     */
+    uint16_t size() const { return _count; }
+
+
+	/** isRunning
+     *  @return true si el grupo está parpadeando
+     */
+    bool isRunning() const { return _running; }
+
+
+  private:
+    LedScheduler* _sched;                                   /// Planificador compartido
+    LedScheduler::Event _ev;                                /// Único evento del grupo
+    Member* _members;                                       /// Miembros
+    uint16_t _count;                                        /// Nº de miembros
+    uint16_t _max_members;                                  /// Capacidad
+    uint32_t _epoch;                                        /// Inicio de un ciclo (se mantiene próximo al instante actual)
+    uint32_t _on_us;                                        /// Tiempo de encendido
+    uint32_t _off_us;                                       /// Tiempo de apagado
+    uint16_t _max_intensity;                                /// Intensidad de encendido (Q16)
+    uint16_t _min_intensity;                                /// Intensidad de apagado (Q16)
+    bool _running;                                          /// Flag para indicar que el grupo parpadea
+
+
+	/** sync
+     *  Calcula el estado y el siguiente cambio de un miembro a partir de su fase en un instante dado
+     *  @param m Miembro
+     *  @param t Instante
+     */
+    void sync(Member& m, uint32_t t);
+
+
+	/** rearm
+     *  Planifica el evento del grupo en el cambio más próximo de sus miembros
+     */
+    void rearm();
+
+
+	/** edgeCb
+     *  Callback del evento del grupo. Ejecuta todos los cambios que vencen en el mismo instante
+     */
+    void edgeCb();
+
+
+	/** Comparación de instantes teniendo en cuenta el desbordamiento */
+    static bool before(uint32_t a, uint32_t b) { return ((int32_t)(a - b) < 0); }
+};
+
+
+
+/** LedGroupT
+ *  Grupo con los miembros alojados en el propio objeto
+ *  @param MaxMembers Nº máximo de miembros
+ */
+template<uint16_t MaxMembers>
+class LedGroupT : public LedGroup{
+  public:
+    LedGroupT(LedScheduler* sched = NULL) : LedGroup(_storage, MaxMembers, sched) {}
+  private:
+    Member _storage[MaxMembers];                            /// Almacenamiento de los miembros
+};
+
+
+
+#endif /*__LedGroup__H */
+
+/**** END OF FILE ****/
+
@@ -0,0 +1,147 @@
+/*
+ * LedOutput.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Políticas de salida y de nivel lógico para los objetos Led. El tipo de salida (pwm o digital) y el nivel
+ *  de activación se resuelven en tiempo de compilación, de forma que la escritura de la salida no contiene
+ *  bifurcaciones por tipo ni por nivel. Led utiliza la función ledWrite<Output, Level> correspondiente.
+ *
+ */
+
+#ifndef __LedOutput__H
+#define __LedOutput__H
+
+#include "mbed.h"
+#include "DigitalOut.h"
+#include "PwmOut.h"
+#include "LedGamma.h"
+
+
+/** Función de escritura de la salida
+ *  @param out Objeto de salida (PwmOut o DigitalOut)
+ *  @param value Intensidad lógica (Q16)
+ *  @param gamma Tabla de corrección gamma (NULL: lineal)
+ *  @param period_us Periodo del pwm en microsegundos
+ *  @param dither Error acumulado del modulador sigma-delta (NULL: sin dithering, redondeo al entero más próximo)
+ */
+typedef void (*LedWriteFn)(void* out, uint16_t value, const LedGammaTable* gamma, uint32_t period_us, uint16_t* dither);
+
+
+/** Función de cálculo del ancho de pulso (sin escritura, ver LedWaveform)
+ *  @param value Intensidad lógica (Q16)
+ *  @param gamma Tabla de corrección gamma (NULL: lineal)
+ *  @param period_us Periodo del pwm en microsegundos
+ *  @return Ancho de pulso en microsegundos
+ */
+typedef uint32_t (*LedPulseFn)(uint16_t value, const LedGammaTable* gamma, uint32_t period_us);
+
+
+/** Nivel lógico: el led se activa con nivel alto */
+struct LedActiveHigh{
+    static uint32_t apply(uint32_t duty, uint32_t full_scale) { (void)full_scale; return duty; }
+};
+
+
+/** Nivel lógico: el led se activa con nivel bajo */
+struct LedActiveLow{
+    static uint32_t apply(uint32_t duty, uint32_t full_scale) { return (full_scale - duty); }
+};
+
+
+/** Salida pwm con corrección gamma y ancho de pulso calculado en aritmética entera */
+struct LedPwmOutput{
+    typedef PwmOut Driver;
+    static const bool Dimmable = true;
+
+    static void init(PwmOut& out, uint32_t period_us){
+        out.period_us(period_us);
+    }
+
+    /** Ciclo de trabajo con corrección gamma y nivel lógico aplicados, en bits de resolución */
+    template<class Level>
+    static uint32_t duty(uint16_t value, const LedGammaTable* gamma, uint8_t& bits){
+        // corrección gamma: dos lecturas de la tabla en flash, interpoladas con los bits bajos
+        uint32_t d = value;
+        bits = 16;
+        if(gamma != NULL){
+            d = gamma->lookup(value);
+            bits = gamma->bits;
+        }
+        return Level::apply(d, (1UL << bits) - 1);
+    }
+
+    /** Escala un ciclo de trabajo de fondo de escala (2^bits - 1) a 2^bits, de forma que el desplazamiento
+     *  equivale a la división exacta y el 100% ocupa todo el periodo */
+    static uint32_t scale(uint32_t duty, uint8_t bits) { return (duty + (duty >> (bits - 1))); }
+
+    /** Ancho de pulso en microsegundos: (periodo * duty) >> bits con redondeo. El producto se calcula en 64
+     *  bits: con un duty de 16 bits, 32 bits sólo admiten periodos de hasta ~65ms */
+    template<class Level>
+    static uint32_t pulse(uint16_t value, const LedGammaTable* gamma, uint32_t period_us){
+        uint8_t bits;
+        uint32_t d = duty<Level>(value, gamma, bits);
+        d = scale(d, bits);
+        return (uint32_t)((((uint64_t)period_us * d) + (1UL << (bits - 1))) >> bits);
+    }
+
+    template<class Level>
+    static void write(PwmOut& out, uint16_t value, const LedGammaTable* gamma, uint32_t period_us, uint16_t* dither){
+        uint8_t bits;
+        uint32_t duty = LedPwmOutput::duty<Level>(value, gamma, bits);
+        uint32_t full_scale = (1UL << bits) - 1;
+#if defined(LED_DOUBLE_OUTPUT_SHIM)
+        // compatibilidad con drivers PwmOut que sólo admiten el ciclo de trabajo en coma flotante
+        (void)period_us;
+        (void)dither;
+        out.write((float)duty / full_scale);
+#else
+        // ancho de pulso en cuentas enteras: (periodo * duty) >> bits con redondeo
+        uint64_t acc = ((uint64_t)period_us * scale(duty, bits));
+        if(dither == NULL){
+            out.pulsewidth_us((int)((acc + (1UL << (bits - 1))) >> bits));
+            return;
+        }
+        // sigma-delta de primer orden: la fracción de microsegundo que no cabe en el timer se acumula y se
+        // entrega en escrituras posteriores, de forma que el ancho medio conserva todos los bits
+        acc += *dither;
+        *dither = (uint16_t)(acc & full_scale);
+        out.pulsewidth_us((int)(acc >> bits));
+#endif
+    }
+};
+
+
+/** Salida digital: cualquier intensidad distinta de 0 activa el led */
+struct LedDigitalOutput{
+    typedef DigitalOut Driver;
+    static const bool Dimmable = false;
+
+    static void init(DigitalOut& out, uint32_t period_us){
+        (void)out;
+        (void)period_us;
+    }
+
+    template<class Level>
+    static void write(DigitalOut& out, uint16_t value, const LedGammaTable* gamma, uint32_t period_us, uint16_t* dither){
+        (void)gamma;
+        (void)period_us;
+        (void)dither;
+        out.write((int)Level::apply((value != 0)? 1 : 0, 1));
+    }
+};
+
+
+/** Adaptador de una política de salida y nivel a LedWriteFn */
+template<class Output, class Level>
+void ledWrite(void* out, uint16_t value, const LedGammaTable* gamma, uint32_t period_us, uint16_t* dither){
+    Output::template write<Level>(*static_cast<typename Output::Driver*>(out), value, gamma, period_us, dither);
+}
+
+
+
+#endif /*__LedOutput__H */
+
+/**** END OF FILE ****/
+
@@ -0,0 +1,66 @@
+/*
+ * LedPattern.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedPattern.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void LedPatternCursor::start(const LedPattern* pattern){
+    _code = (pattern != NULL && pattern->count > 0)? pattern->ops : NULL;
+    _count = (_code != NULL)? pattern->count : 0;
+    _pc = 0;
+    _loop_left = 0;
+    _ops = 0;
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedPatternCursor::next(LedPatternOp& op){
+    while(_code != NULL){
+        // sin instrucciones que consuman tiempo, el patrón se detiene en lugar de bloquear la interrupción
+        if(_pc >= _count || _ops >= MaxOpsPerStep){
+            _code = NULL;
+            return false;
+        }
+        op = _code[_pc];
+        _ops++;
+        switch(op.code){
+            case LedPatternOp::OpSet:
+            case LedPatternOp::OpRamp:
+            case LedPatternOp::OpHold:
+                _pc++;
+                if(op.arg16 != 0){
+                    _ops = 0;
+                }
+                return true;
+
+            case LedPatternOp::OpLoop:
+                // la primera vez que se alcanza carga el nº de pasadas; la última continúa
+                if(_loop_left == 0){
+                    _loop_left = (op.arg8 == 0)? 1 : op.arg8;
+                }
+                _loop_left--;
+                _pc = (_loop_left != 0)? op.arg16 : (_pc + 1);
+                break;
+
+            case LedPatternOp::OpJump:
+                _pc = op.arg16;
+                break;
+
+            case LedPatternOp::OpEnd:
+            default:
+                _code = NULL;
+                return false;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,147 @@
+/*
+ * LedPattern.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Patrones de luz compilados en un bytecode compacto. Un patrón es una lista de instrucciones de 4 bytes
+ *  (fijar nivel, rampa, espera, bucle, salto y fin) que puede construirse en tiempo de compilación y residir
+ *  en flash. Los leds no copian el patrón: lo ejecutan por referencia mediante un cursor (LedPatternCursor),
+ *  de forma que muchos leds pueden compartir el mismo patrón. El intérprete avanza en el callback del timer
+ *  hasta la siguiente instrucción que consume tiempo, con deadlines absolutos encadenados.
+ *
+ *  Los niveles se codifican en 8 bits (0..255) para que el intérprete obtenga el valor Q16 sin divisiones.
+ *
+ *  Ej. de uso:
+ *      // dos parpadeos rápidos, pausa de 1s con respiración, y se repite
+ *      static constexpr LedPatternOp two_blinks_ops[] = {
+ *          LedPatternOp::set(100, 150),        // 0: encendido 150ms
+ *          LedPatternOp::set(0, 150),          // 1: apagado 150ms
+ *          LedPatternOp::loop(2, 0),           // 2: repite 0..1 dos veces en total
+ *          LedPatternOp::ramp(30, 500),        // 3: sube al 30% en 500ms
+ *          LedPatternOp::ramp(0, 500),         // 4: baja al 0% en 500ms
+ *          LedPatternOp::jump(0),              // 5: vuelve al inicio
+ *      };
+ *      static constexpr LedPattern two_blinks(two_blinks_ops, 6);
+ *      ...
+ *      led.play(&two_blinks);
+ *
+ */
+
+#ifndef __LedPattern__H
+#define __LedPattern__H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/** Instrucción del bytecode */
+struct LedPatternOp{
+    enum Code{
+        OpSet,                                              /// Fija el nivel y espera ms
+        OpRamp,                                             /// Rampa hasta el nivel en ms (la espera coincide con la rampa)
+        OpHold,                                             /// Mantiene el nivel actual durante ms
+        OpLoop,                                             /// Repite desde target hasta completar count pasadas
+        OpJump,                                             /// Salto incondicional a target
+        OpEnd,                                              /// Fin del patrón (el led conserva el nivel)
+    };
+
+    uint8_t code;                                           /// Código de operación (Code)
+    uint8_t arg8;                                           /// Nivel 0..255 (set, ramp) o nº de pasadas (loop)
+    uint16_t arg16;                                         /// Duración en ms (set, ramp, hold) o instrucción destino (loop, jump)
+
+    constexpr LedPatternOp(Code c = OpEnd, uint8_t a8 = 0, uint16_t a16 = 0) : code((uint8_t)c), arg8(a8), arg16(a16) {}
+
+	/** Constructores de instrucciones. Los niveles se indican en porcentaje 0-100% */
+    static constexpr LedPatternOp set(uint8_t intensity, uint16_t ms = 0) { return LedPatternOp(OpSet, toLevel(intensity), ms); }
+    static constexpr LedPatternOp ramp(uint8_t intensity, uint16_t ms) { return LedPatternOp(OpRamp, toLevel(intensity), ms); }
+    static constexpr LedPatternOp hold(uint16_t ms) { return LedPatternOp(OpHold, 0, ms); }
+    static constexpr LedPatternOp loop(uint8_t count, uint16_t target) { return LedPatternOp(OpLoop, count, target); }
+    static constexpr LedPatternOp jump(uint16_t target) { return LedPatternOp(OpJump, 0, target); }
+    static constexpr LedPatternOp end() { return LedPatternOp(OpEnd); }
+
+	/** Conversión de porcentaje a nivel de 8 bits y de nivel a Q16 */
+    static constexpr uint8_t toLevel(uint8_t intensity) { return (uint8_t)((((intensity > 100)? 100 : intensity) * 255 + 50) / 100); }
+    static constexpr uint16_t toQ16(uint8_t level) { return (uint16_t)(level * 257); }
+};
+
+
+/** Patrón: referencia a una lista de instrucciones (no se copia) */
+struct LedPattern{
+    const LedPatternOp* ops;                                /// Instrucciones
+    uint16_t count;                                         /// Nº de instrucciones
+
+    constexpr LedPattern(const LedPatternOp* o = NULL, uint16_t n = 0) : ops(o), count(n) {}
+};
+
+
+
+class LedPatternCursor{
+  public:
+
+    /** Nº máximo de instrucciones ejecutadas sin consumir tiempo (protección frente a bucles vacíos) */
+    static const uint8_t MaxOpsPerStep = 32;
+
+
+	/** Constructor */
+    LedPatternCursor() : _code(NULL), _count(0), _pc(0), _loop_left(0), _ops(0) {}
+
+
+	/** start
+     *  Inicia la ejecución de un patrón desde su primera instrucción
+     *  @param pattern Patrón (sus instrucciones deben permanecer válidas mientras se ejecuta)
+     */
+    void start(const LedPattern* pattern);
+
+
+	/** stop
+     *  Detiene la ejecución
+     */
+    void stop() { _code = NULL; }
+
+
+	/** next
+     *  Resuelve las instrucciones de control (loop, jump) y obtiene la siguiente instrucción de nivel o de
+     *  espera (set, ramp, hold). Al llegar al final, o si se supera MaxOpsPerStep, la ejecución se detiene
+     *  @param op Recibe la instrucción
+     *  @return true si hay instrucción, false si el patrón ha finalizado
+     */
+    bool next(LedPatternOp& op);
+
+
+	/** isRunning
+     *  @return true si hay un patrón en ejecución
+     */
+    bool isRunning() const { return (_code != NULL); }
+
+
+	/** getPosition
+     *  @return Índice de la siguiente instrucción
+     */
+    uint16_t getPosition() const { return _pc; }
+
+
+	/** atCycleEnd
+     *  Indica si el cursor ha completado una pasada del patrón: la siguiente instrucción es el salto al inicio,
+     *  el fin del patrón o no hay patrón en ejecución
+     *  @return true si está en el límite de una pasada
+     */
+    bool atCycleEnd() const {
+        return (_code == NULL || _pc >= _count || _code[_pc].code == LedPatternOp::OpEnd ||
+                (_code[_pc].code == LedPatternOp::OpJump && _code[_pc].arg16 == 0));
+    }
+
+
+  private:
+    const LedPatternOp* _code;                              /// Instrucciones en ejecución (NULL: ninguna)
+    uint16_t _count;                                        /// Nº de instrucciones
+    uint16_t _pc;                                           /// Siguiente instrucción
+    uint8_t _loop_left;                                     /// Pasadas restantes del bucle en curso (los bucles no se anidan)
+    uint8_t _ops;                                           /// Instrucciones ejecutadas sin consumir tiempo
+};
+
+
+
+#endif /*__LedPattern__H */
+
+/**** END OF FILE ****/
@@ -0,0 +1,170 @@
+/*
+ * LedPatternRegistry.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedPatternRegistry.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedPatternRegistry::LedPatternRegistry(Entry* entries, uint16_t max_patterns, LedPatternOp* pool, uint16_t max_ops){
+    _entries = entries;
+    _count = 0;
+    _max_patterns = max_patterns;
+    _pool = pool;
+    _used_ops = 0;
+    _max_ops = max_ops;
+}
+
+
+//------------------------------------------------------------------------------------
+LedPatternRegistry* LedPatternRegistry::getDefault(){
+    static LedPatternRegistryT<DefaultMaxPatterns, DefaultMaxOps> registry;
+    return &registry;
+}
+
+
+//------------------------------------------------------------------------------------
+LedPatternHandle LedPatternRegistry::intern(const LedPatternOp* ops, uint16_t count){
+    if(ops == NULL || count == 0){
+        return NULL;
+    }
+    uint32_t h = hash(ops, count);
+    LedPatternHandle handle = NULL;
+    // los patrones registrados no se modifican: la búsqueda y el alta son atómicas frente a otros hilos
+    core_util_critical_section_enter();
+    // una entrada liberada conserva su contenido hasta que se reutiliza: también puede recuperarse
+    Entry* free = NULL;
+    for(uint16_t i=0;i<_count;i++){
+        Entry& e = _entries[i];
+        if(e.hash == h && e.pattern.count == count && equals(e.pattern.ops, ops, count)){
+            e.refs++;
+            handle = &e.pattern;
+            break;
+        }
+        if(e.refs == 0 && e.capacity >= count && (free == NULL || e.capacity < free->capacity)){
+            free = &e;
+        }
+    }
+    if(handle == NULL){
+        if(free == NULL && _count < _max_patterns && (_max_ops - _used_ops) >= count){
+            free = &_entries[_count];
+            free->capacity = count;
+            free->pattern = LedPattern(&_pool[_used_ops], count);
+            _used_ops += count;
+            _count++;
+        }
+        if(free != NULL){
+            // las instrucciones de una entrada sin referencias no las lee ningún led
+            LedPatternOp* dst = const_cast<LedPatternOp*>(free->pattern.ops);
+            for(uint16_t i=0;i<count;i++){
+                dst[i] = ops[i];
+            }
+            free->pattern = LedPattern(dst, count);
+            free->hash = h;
+            free->refs = 1;
+            handle = &free->pattern;
+        }
+    }
+    core_util_critical_section_exit();
+    return handle;
+}
+
+
+//------------------------------------------------------------------------------------
+LedPatternHandle LedPatternRegistry::intern(const uint32_t blinks[], uint8_t count){
+    if(count == 0 || count > MaxBlinkCount){
+        return NULL;
+    }
+    // los tiempos pares corresponden a un ON y los impares a un OFF
+    LedPatternOp ops[MaxBlinkCount + 1];
+    for(uint8_t i=0;i<count;i++){
+        if(blinks[i] > 0xFFFF){
+            return NULL;
+        }
+        ops[i] = LedPatternOp::set((i & 1)? 0 : 100, (uint16_t)blinks[i]);
+    }
+    ops[count] = LedPatternOp::jump(0);
+    return intern(ops, count + 1);
+}
+
+
+
+//------------------------------------------------------------------------------------
+void LedPatternRegistry::acquire(LedPatternHandle pattern){
+    Entry* e = find(pattern);
+    if(e == NULL){
+        return;
+    }
+    core_util_critical_section_enter();
+    e->refs++;
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+void LedPatternRegistry::release(LedPatternHandle pattern){
+    Entry* e = find(pattern);
+    if(e == NULL){
+        return;
+    }
+    core_util_critical_section_enter();
+    e->refs = (e->refs > 0)? (e->refs - 1) : 0;
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+uint16_t LedPatternRegistry::getRefs(LedPatternHandle pattern) const{
+    Entry* e = find(pattern);
+    return (e != NULL)? e->refs : 0;
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+uint32_t LedPatternRegistry::hash(const LedPatternOp* ops, uint16_t count){
+    uint32_t h = 2166136261UL;
+    for(uint16_t i=0;i<count;i++){
+        const uint8_t b[4] = { ops[i].code, ops[i].arg8, (uint8_t)ops[i].arg16, (uint8_t)(ops[i].arg16 >> 8) };
+        for(uint8_t k=0;k<4;k++){
+            h = (h ^ b[k]) * 16777619UL;
+        }
+    }
+    return h;
+}
+
+
+//------------------------------------------------------------------------------------
+LedPatternRegistry::Entry* LedPatternRegistry::find(LedPatternHandle pattern) const{
+    // el patrón es el primer miembro de la entrada: basta con comprobar que apunta a una entrada ocupada
+    uintptr_t p = (uintptr_t)pattern;
+    uintptr_t first = (uintptr_t)&_entries[0];
+    if(pattern == NULL || p < first || p >= (uintptr_t)&_entries[_count] || ((p - first) % sizeof(Entry)) != 0){
+        return NULL;
+    }
+    return (Entry*)pattern;
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedPatternRegistry::equals(const LedPatternOp* a, const LedPatternOp* b, uint16_t count){
+    for(uint16_t i=0;i<count;i++){
+        if(a[i].code != b[i].code || a[i].arg8 != b[i].arg8 || a[i].arg16 != b[i].arg16){
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,168 @@
+/*
+ * LedPatternRegistry.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedPatternRegistry es una biblioteca de patrones inmutables compartida por todos los leds. Cada patrón se
+ *  registra una única vez (interning): al registrar un patrón idéntico a uno existente se obtiene el mismo
+ *  handle, de forma que 200 leds mostrando "dos parpadeos rápidos" comparten una sola copia. Los patrones
+ *  registrados no se modifican; un led sólo almacena el handle en curso y su cursor, y cambiar de patrón es
+ *  una asignación de handle (O(1)), sin copiar tiempos.
+ *
+ *  Cada patrón mantiene un contador de referencias: intern y acquire lo incrementan y release lo decrementa.
+ *  Los leds mantienen una referencia mientras ejecutan o tienen preparado un patrón, de forma que las listas
+ *  de setBlinkMode que dejan de utilizarse se liberan y su entrada (y sus instrucciones en el pool) se
+ *  reutiliza para otro patrón de igual o menor tamaño. Un handle obtenido con intern es válido hasta su release.
+ *
+ *  Las listas de temporizaciones de setBlinkMode se compilan al bytecode de LedPattern con duraciones de 16 bits.
+ *
+ *  Ej. de uso:
+ *      static const uint32_t two_blinks[] = {250, 250, 250, 1000};
+ *      LedPatternHandle h = LedPatternRegistry::getDefault()->intern(two_blinks, 4);
+ *      for(int i=0;i<200;i++){
+ *          leds[i].play(h);
+ *      }
+ *
+ */
+
+#ifndef __LedPatternRegistry__H
+#define __LedPatternRegistry__H
+
+#include "mbed.h"
+#include "LedPattern.h"
+
+
+/** Handle de un patrón registrado (NULL: ninguno). El patrón referenciado es inmutable */
+typedef const LedPattern* LedPatternHandle;
+
+
+
+class LedPatternRegistry{
+  public:
+
+    static const uint16_t DefaultMaxPatterns = 32;          /// Nº máximo de patrones del registro por defecto
+    static const uint16_t DefaultMaxOps = 256;              /// Nº máximo de instrucciones del registro por defecto
+    static const uint8_t MaxBlinkCount = 16;                /// Máximo nº de tiempos de una lista de parpadeo
+
+    /** Entrada del registro */
+    struct Entry{
+        LedPattern pattern;                                 /// Patrón (instrucciones alojadas en el pool)
+        uint32_t hash;                                      /// Hash del contenido
+        uint16_t refs;                                      /// Nº de referencias (0: entrada reutilizable)
+        uint16_t capacity;                                  /// Nº de instrucciones reservadas en el pool
+    };
+
+
+	/** Constructor
+     *  @param entries Array de max_patterns entradas
+     *  @param max_patterns Nº máximo de patrones
+     *  @param pool Array de max_ops instrucciones
+     *  @param max_ops Nº máximo de instrucciones entre todos los patrones
+     */
+    LedPatternRegistry(Entry* entries, uint16_t max_patterns, LedPatternOp* pool, uint16_t max_ops);
+
+
+	/** getDefault
+     *  Obtiene el registro compartido por defecto (en memoria estática)
+     *  @return Registro por defecto
+     */
+    static LedPatternRegistry* getDefault();
+
+
+	/** intern
+     *  Registra un patrón, copiando sus instrucciones al pool, o devuelve el handle de uno idéntico. En ambos
+     *  casos se obtiene una referencia, que se libera con release
+     *  @param ops Instrucciones
+     *  @param count Nº de instrucciones
+     *  @return Handle del patrón, NULL si no hay espacio
+     */
+    LedPatternHandle intern(const LedPatternOp* ops, uint16_t count);
+
+
+	/** intern
+     *  Compila y registra una lista de temporizaciones de parpadeo (ver Led::setBlinkMode)
+     *  @param blinks Lista de temporizaciones en ms (máximo 65535ms cada una)
+     *  @param count Nº de temporizaciones (máximo MaxBlinkCount)
+     *  @return Handle del patrón, NULL si la lista no es válida o no hay espacio
+     */
+    LedPatternHandle intern(const uint32_t blinks[], uint8_t count);
+
+
+	/** acquire, release
+     *  Obtienen y liberan una referencia a un patrón. No hacen nada si el patrón no pertenece al registro
+     *  (ej. un LedPattern constexpr del usuario) o es NULL
+     *  @param pattern Patrón
+     */
+    void acquire(LedPatternHandle pattern);
+    void release(LedPatternHandle pattern);
+
+
+	/** getRefs
+     *  @param pattern Patrón
+     *  @return Nº de referencias (0 si no pertenece al registro)
+     */
+    uint16_t getRefs(LedPatternHandle pattern) const;
+
+
+	/** size
+     *  @return Nº de entradas ocupadas (incluidas las liberadas pendientes de reutilizar)
+     */
+    uint16_t size() const { return _count; }
+
+
+	/** getUsedOps
+     *  @return Nº de instrucciones ocupadas en el pool
+     */
+    uint16_t getUsedOps() const { return _used_ops; }
+
+
+  private:
+    Entry* _entries;                                        /// Patrones registrados
+    uint16_t _count;                                        /// Nº de patrones
+    uint16_t _max_patterns;                                 /// Capacidad de patrones
+    LedPatternOp* _pool;                                    /// Instrucciones de todos los patrones
+    uint16_t _used_ops;                                     /// Instrucciones ocupadas
+    uint16_t _max_ops;                                      /// Capacidad del pool
+
+
+	/** hash
+     *  Calcula el hash (FNV-1a) de una lista de instrucciones
+     */
+    static uint32_t hash(const LedPatternOp* ops, uint16_t count);
+
+
+	/** equals
+     *  Compara dos listas de instrucciones
+     */
+    static bool equals(const LedPatternOp* a, const LedPatternOp* b, uint16_t count);
+
+
+	/** find
+     *  Obtiene la entrada de un patrón
+     *  @return Entrada, NULL si no pertenece al registro
+     */
+    Entry* find(LedPatternHandle pattern) const;
+};
+
+
+
+/** LedPatternRegistryT
+ *  Registro con las entradas y el pool alojados en el propio objeto
+ *  @param MaxPatterns Nº máximo de patrones
+ *  @param MaxOps Nº máximo de instrucciones
+ */
+template<uint16_t MaxPatterns, uint16_t MaxOps>
+class LedPatternRegistryT : public LedPatternRegistry{
+  public:
+    LedPatternRegistryT() : LedPatternRegistry(_entries, MaxPatterns, _pool, MaxOps) {}
+  private:
+    Entry _entries[MaxPatterns];                            /// Almacenamiento de las entradas
+    LedPatternOp _pool[MaxOps];                             /// Almacenamiento de las instrucciones
+};
+
+
+
+#endif /*__LedPatternRegistry__H */
+
+/**** END OF FILE ****/
@@ -0,0 +1,101 @@
+/*
+ * LedRamp.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedRamp.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedRamp::LedRamp(){
+    _table = getTable(LedEasingLinear);
+    _from = 0;
+    _to = 0;
+    _delta = 0;
+    _steps = 0;
+    _step = 0;
+    _idx_q16 = 0;
+    _idx_inc = 0;
+    _deadline = 0;
+    _step_us = 0;
+    _rem_us = 0;
+    _err = 0;
+}
+
+
+//------------------------------------------------------------------------------------
+const uint16_t* LedRamp::getTable(LedEasing curve){
+    switch(curve){
+        case LedEasingIn:       return LedEasingTable<LedEasingIn>::lut;
+        case LedEasingOut:      return LedEasingTable<LedEasingOut>::lut;
+        case LedEasingInOut:    return LedEasingTable<LedEasingInOut>::lut;
+        case LedEasingExp:      return LedEasingTable<LedEasingExp>::lut;
+        case LedEasingSCurve:   return LedEasingTable<LedEasingSCurve>::lut;
+        case LedEasingLinear:
+        default:                return LedEasingTable<LedEasingLinear>::lut;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void LedRamp::start(uint16_t from, uint16_t to, uint32_t duration_us, uint32_t period_us, const uint16_t* table, uint32_t t0){
+    _table = table;
+    _from = from;
+    _to = to;
+    _delta = (int32_t)to - (int32_t)from;
+    period_us = (period_us == 0)? 1 : period_us;
+
+    // cada paso dura un nº entero de periodos pwm, con un máximo de MaxSteps pasos
+    uint32_t periods = (duration_us + (period_us * MaxSteps) - 1) / (period_us * MaxSteps);
+    periods = (periods == 0)? 1 : periods;
+    uint32_t steps = duration_us / (period_us * periods);
+    _steps = (steps == 0)? 1 : (uint16_t)steps;
+
+    // el resto se reparte entre los pasos para que el final coincida con t0 + duration_us
+    _step_us = duration_us / _steps;
+    _rem_us = duration_us % _steps;
+    _err = 0;
+    _step = 0;
+    _idx_q16 = 0;
+    _idx_inc = ((uint32_t)(LedRampTableSize - 1) << 16) / _steps;
+    _deadline = t0 + _step_us;
+    _err += _rem_us;
+    if(_err >= _steps){
+        _err -= _steps;
+        _deadline++;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedRamp::step(uint16_t& level){
+    if(_step >= _steps){
+        level = _to;
+        return false;
+    }
+    _step++;
+    if(_step >= _steps){
+        // último paso: intensidad final exacta
+        level = _to;
+        return false;
+    }
+    _idx_q16 += _idx_inc;
+    int32_t frac = _table[_idx_q16 >> 16];
+    level = (uint16_t)((int32_t)_from + ((_delta * frac) >> 15));
+
+    // siguiente instante absoluto (Bresenham sobre el resto)
+    _deadline += _step_us;
+    _err += _rem_us;
+    if(_err >= _steps){
+        _err -= _steps;
+        _deadline++;
+    }
+    return true;
+}
@@ -0,0 +1,150 @@
+/*
+ * LedRamp.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedRamp es el motor de rampas de intensidad. Una rampa se define por su duración total real, se divide en
+ *  pasos múltiplos del periodo del pwm y sigue una curva de transición (lineal, ease-in/out, exponencial, S)
+ *  evaluada a partir de tablas precalculadas en tiempo de compilación. Los instantes de cada paso son absolutos
+ *  y se reparten con aritmética entera (sin divisiones en la interrupción), de forma que el último paso vence
+ *  exactamente en t0 + duración.
+ *
+ */
+
+#ifndef __LedRamp__H
+#define __LedRamp__H
+
+#include <stdint.h>
+#include "LedGamma.h"
+
+
+/** Curvas de transición disponibles */
+enum LedEasing{
+    LedEasingLinear,        /// Lineal
+    LedEasingIn,            /// Aceleración cuadrática
+    LedEasingOut,           /// Deceleración cuadrática
+    LedEasingInOut,         /// Aceleración y deceleración cuadráticas
+    LedEasingExp,           /// Exponencial (2^10x)
+    LedEasingSCurve,        /// Curva S (smootherstep)
+};
+
+
+/** Nº de entradas de las tablas de transición y valor de escala (Q15) */
+static const uint16_t LedRampTableSize = 256;
+static const uint16_t LedRampFullScale = 0x8000;
+
+
+/** Evaluación de las curvas (sólo se utiliza en tiempo de compilación) */
+constexpr double ledExp(double x, int n = 0, double term = 1.0){
+    return (n > 40)? 0 : (term + ledExp(x, n + 1, (term * x) / (n + 1)));
+}
+
+constexpr double ledEasingEval(LedEasing curve, double x){
+    return (curve == LedEasingLinear)? x :
+           (curve == LedEasingIn)? (x * x) :
+           (curve == LedEasingOut)? (1.0 - ((1.0 - x) * (1.0 - x))) :
+           (curve == LedEasingInOut)? ((x < 0.5)? (2.0 * x * x) : (1.0 - (2.0 * (1.0 - x) * (1.0 - x)))) :
+           (curve == LedEasingExp)? ((ledExp(6.931471805599453 * x) - 1.0) / 1023.0) :
+           (x * x * x * ((x * ((x * 6.0) - 15.0)) + 10.0));
+}
+
+constexpr uint16_t ledEasingValue(LedEasing curve, uint16_t i){
+    return (uint16_t)((ledEasingEval(curve, (double)i / (LedRampTableSize - 1)) * LedRampFullScale) + 0.5);
+}
+
+
+/** Tabla de transición (Q15, 0..LedRampFullScale) para una curva */
+template<LedEasing Curve, class Seq = typename LedMakeSeq<LedRampTableSize>::type>
+struct LedEasingTable;
+
+template<LedEasing Curve, uint16_t... I>
+struct LedEasingTable<Curve, LedIndexSeq<I...> >{
+    static constexpr uint16_t lut[sizeof...(I)] = { ledEasingValue(Curve, I)... };
+};
+
+template<LedEasing Curve, uint16_t... I>
+constexpr uint16_t LedEasingTable<Curve, LedIndexSeq<I...> >::lut[sizeof...(I)];
+
+
+
+class LedRamp{
+  public:
+
+    static const uint16_t MaxSteps = LedRampTableSize - 1;  /// Nº máximo de pasos de una rampa
+
+
+	/** Constructor */
+    LedRamp();
+
+
+	/** getTable
+     *  Obtiene la tabla precalculada de una curva de transición
+     *  @param curve Curva
+     *  @return Tabla de LedRampTableSize entradas (Q15)
+     */
+    static const uint16_t* getTable(LedEasing curve);
+
+
+	/** start
+     *  Inicia una rampa
+     *  @param from Intensidad inicial (Q16)
+     *  @param to Intensidad final (Q16)
+     *  @param duration_us Duración total de la rampa en microsegundos
+     *  @param period_us Periodo del pwm en microsegundos (resolución mínima de cada paso)
+     *  @param table Tabla de transición de LedRampTableSize entradas (Q15)
+     *  @param t0 Instante de inicio (base de tiempos del planificador)
+     */
+    void start(uint16_t from, uint16_t to, uint32_t duration_us, uint32_t period_us, const uint16_t* table, uint32_t t0);
+
+
+	/** step
+     *  Ejecuta el siguiente paso de la rampa
+     *  @param level Recibe la intensidad del paso (Q16)
+     *  @return true si quedan pasos pendientes, false si la rampa ha finalizado
+     */
+    bool step(uint16_t& level);
+
+
+	/** nextDeadline
+     *  Obtiene el instante absoluto del siguiente paso
+     *  @return Instante en microsegundos
+     */
+    uint32_t nextDeadline() const { return _deadline; }
+
+
+	/** getTarget
+     *  Obtiene la intensidad final de la rampa
+     *  @return Intensidad Q16
+     */
+    uint16_t getTarget() const { return _to; }
+
+
+	/** isRunning
+     *  Indica si hay una rampa en curso
+     *  @return true si está en curso
+     */
+    bool isRunning() const { return (_step < _steps); }
+
+
+  private:
+    const uint16_t* _table;                                 /// Tabla de transición
+    uint16_t _from;                                         /// Intensidad inicial
+    uint16_t _to;                                           /// Intensidad final
+    int32_t _delta;                                         /// Diferencia final - inicial
+    uint16_t _steps;                                        /// Nº total de pasos
+    uint16_t _step;                                         /// Paso actual
+    uint32_t _idx_q16;                                      /// Índice en la tabla (Q16)
+    uint32_t _idx_inc;                                      /// Incremento del índice por paso (Q16)
+    uint32_t _deadline;                                     /// Instante del siguiente paso
+    uint32_t _step_us;                                      /// Duración base de cada paso
+    uint32_t _rem_us;                                       /// Resto de la división duración/pasos
+    uint32_t _err;                                          /// Acumulador para repartir el resto
+};
+
+
+
+#endif /*__LedRamp__H */
+
+/**** END OF FILE ****/
+
@@ -0,0 +1,406 @@
+/*
+ * LedScheduler.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedScheduler.h"
+#include "LedCommandQueue.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedScheduler::LedScheduler(uint16_t max_events){
+    _max_events = max_events;
+    _heap = new Event*[_max_events];
+    _owns_heap = true;
+    init();
+}
+
+
+//------------------------------------------------------------------------------------
+LedScheduler::LedScheduler(Event** storage, uint16_t max_events){
+    _max_events = max_events;
+    _heap = storage;
+    _owns_heap = false;
+    init();
+}
+
+
+//------------------------------------------------------------------------------------
+LedScheduler::~LedScheduler(){
+    _tick.detach();
+    for(uint16_t i=0;i<_count;i++){
+        _heap[i]->index = -1;
+    }
+    while(_deferred != NULL){
+        _deferred->queued = false;
+        _deferred = _deferred->next;
+    }
+    if(_owns_heap){
+        delete[](_heap);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+LedScheduler* LedScheduler::getDefault(){
+    // montículo en memoria estática: los leds que no caben no se admiten (ver Led::isReady)
+    static LedSchedulerT<DefaultMaxEvents> sched;
+    return &sched;
+}
+
+
+//------------------------------------------------------------------------------------
+uint32_t LedScheduler::now(){
+    return (uint32_t)_timer.read_us();
+}
+
+
+//------------------------------------------------------------------------------------
+int LedScheduler::schedule(Event* evt, Callback<void()> cb, uint32_t delay_us){
+    delay_us = (delay_us < MinDelayUs)? MinDelayUs : delay_us;
+    return scheduleAt(evt, cb, now() + delay_us);
+}
+
+
+//------------------------------------------------------------------------------------
+int LedScheduler::scheduleAt(Event* evt, Callback<void()> cb, uint32_t deadline_us){
+    core_util_critical_section_enter();
+    if(evt->index >= 0){
+        heapRemove(evt);
+    }
+    else if(_count >= _max_events){
+        _stats_lock.writeBegin();
+        _stats.arm_failures++;
+        _stats_lock.writeEnd();
+        core_util_critical_section_exit();
+        return -1;
+    }
+    evt->cb = cb;
+    evt->deadline = deadline_us;
+    heapInsert(evt);
+    // durante la ejecución de eventos, el rearme se hace al finalizar
+    if(!_dispatching){
+        rearm();
+    }
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::cancel(Event* evt){
+    core_util_critical_section_enter();
+    if(evt->index >= 0){
+        heapRemove(evt);
+        // sin eventos pendientes el timer se detiene; en otro caso se arma en el nuevo límite
+        if(!_dispatching){
+            rearm();
+        }
+    }
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::wakeup(){
+    uint32_t expected = 0;
+    // sólo el primer productor desde la última pasada arma el evento
+    if(core_util_atomic_cas_u32(&_wake_pending, &expected, 1)){
+        core_util_critical_section_enter();
+        if(scheduleAt(&_ev_wake, callback(this, &LedScheduler::wakeCb), now()) != 0){
+            // sin espacio en el montículo: la siguiente solicitud lo reintentará
+            core_util_atomic_store_u32(&_wake_pending, 0);
+        }
+        core_util_critical_section_exit();
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+int LedScheduler::reserve(uint16_t events){
+    core_util_critical_section_enter();
+    _reserved += events;
+    uint32_t needed = _reserved;
+    uint16_t max_events = _max_events;
+    core_util_critical_section_exit();
+    if(needed <= max_events){
+        return 0;
+    }
+    if(!_owns_heap || needed > 0xFFFF){
+        // la reserva no se admite: no ocupa capacidad
+        release(events);
+        return -1;
+    }
+    // crece al doble (o a lo necesario) para no reservar memoria con cada led; la reserva se hace fuera de
+    // la sección crítica y sólo la copia de los punteros se hace dentro
+    uint32_t size = ((uint32_t)max_events * 2 > needed)? ((uint32_t)max_events * 2) : needed;
+    size = (size > 0xFFFF)? 0xFFFF : size;
+    Event** heap = new Event*[size];
+    core_util_critical_section_enter();
+    if(size <= _max_events){
+        // otro llamante ya lo ha ampliado
+        core_util_critical_section_exit();
+        delete[](heap);
+        return 0;
+    }
+    for(uint16_t i=0;i<_count;i++){
+        heap[i] = _heap[i];
+    }
+    Event** old = _heap;
+    _heap = heap;
+    _max_events = (uint16_t)size;
+    core_util_critical_section_exit();
+    delete[](old);
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::release(uint16_t events){
+    core_util_critical_section_enter();
+    _reserved = (_reserved > events)? (_reserved - events) : 0;
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedScheduler::defer(Deferred* d, Callback<void()> cb){
+    core_util_critical_section_enter();
+    if(!_dispatching){
+        core_util_critical_section_exit();
+        cb();
+        return false;
+    }
+    if(!d->queued){
+        d->cb = cb;
+        d->queued = true;
+        d->next = NULL;
+        // orden de llegada: las salidas se escriben en el mismo orden que sin diferir
+        *_deferred_tail = d;
+        _deferred_tail = &d->next;
+    }
+    core_util_critical_section_exit();
+    return true;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::undefer(Deferred* d){
+    core_util_critical_section_enter();
+    if(d->queued){
+        Deferred** p = &_deferred;
+        while(*p != d){
+            p = &(*p)->next;
+        }
+        *p = d->next;
+        if(_deferred_tail == &d->next){
+            _deferred_tail = p;
+        }
+        d->next = NULL;
+        d->queued = false;
+    }
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::init(){
+    _count = 0;
+    _dispatching = false;
+    _armed = false;
+    _armed_deadline = 0;
+    _queue = NULL;
+    // evento propio para aplicar los comandos encolados
+    _reserved = 1;
+    _wake_pending = 0;
+    _deferred = NULL;
+    _deferred_tail = &_deferred;
+    _late = 0;
+    _stats.clear();
+    _timer.start();
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::isrCb(){
+    core_util_critical_section_enter();
+    // el Ticker es periódico: se utiliza como disparo único y sólo se vuelve a armar si quedan eventos
+    _tick.detach();
+    _armed = false;
+    _dispatching = true;
+    uint32_t t = now();
+    uint32_t events = 0;
+    // ejecuta todos los eventos vencidos en una única pasada
+    while(_count > 0 && !before(t, _heap[0]->deadline)){
+        Event* evt = _heap[0];
+        heapRemove(evt);
+        _late = t - evt->deadline;
+        _stats_lock.writeBegin();
+        _stats.lateness.add(_late);
+        _stats_lock.writeEnd();
+        events++;
+        core_util_critical_section_exit();
+        evt->cb();
+        core_util_critical_section_enter();
+    }
+    // acciones diferidas: una única ejecución por acción y pasada
+    while(_deferred != NULL){
+        Deferred* d = _deferred;
+        _deferred = d->next;
+        _deferred_tail = (_deferred == NULL)? &_deferred : _deferred_tail;
+        d->next = NULL;
+        d->queued = false;
+        core_util_critical_section_exit();
+        d->cb();
+        core_util_critical_section_enter();
+    }
+    _dispatching = false;
+    _stats_lock.writeBegin();
+    _stats.passes++;
+    _stats.events += events;
+    _stats.isr_time.add(now() - t);
+    _stats_lock.writeEnd();
+    rearm();
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::wakeCb(){
+    // se libera el flag antes de vaciar la cola: un comando posterior solicitará otra pasada
+    core_util_atomic_store_u32(&_wake_pending, 0);
+    if(_queue != NULL){
+        _queue->drain();
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::rearm(){
+    if(_count == 0){
+        // sin eventos pendientes no hay despertares
+        _tick.detach();
+        _armed = false;
+        return;
+    }
+    uint32_t deadline = wakeTime();
+    // si el timer ya está armado para ese instante, no es necesario tocarlo
+    if(_armed && deadline == _armed_deadline){
+        return;
+    }
+    uint32_t t = now();
+    uint32_t delay = before(t, deadline)? (deadline - t) : MinDelayUs;
+    _armed = true;
+    _armed_deadline = deadline;
+    _tick.attach_us(callback(this, &LedScheduler::isrCb), delay);
+}
+
+
+//------------------------------------------------------------------------------------
+uint32_t LedScheduler::wakeTime() const{
+    // recorrido en profundidad con pila propia: cada nodo extraído apila como mucho sus dos hijos, de forma
+    // que la pila no supera la profundidad del montículo
+    uint16_t stack[MaxHeapDepth + 1];
+    uint8_t top = 0;
+    uint8_t scanned = 0;
+    uint32_t best = _heap[0]->deadline + _heap[0]->slack;
+    stack[top++] = 0;
+    while(top > 0){
+        uint16_t i = stack[--top];
+        // en un subárbol ningún deadline es anterior al de su raíz: si la raíz no es anterior al límite, se poda
+        if(!before(_heap[i]->deadline, best)){
+            continue;
+        }
+        if(scanned >= MaxWakeScan){
+            // recorrido agotado: el deadline de la raíz acota el de todo su subárbol
+            best = _heap[i]->deadline;
+            continue;
+        }
+        scanned++;
+        uint32_t latest = _heap[i]->deadline + _heap[i]->slack;
+        best = before(latest, best)? latest : best;
+        uint32_t child = (2 * (uint32_t)i) + 1;
+        if((child + 1) < _count){
+            stack[top++] = (uint16_t)(child + 1);
+        }
+        if(child < _count){
+            stack[top++] = (uint16_t)child;
+        }
+    }
+    return best;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::heapInsert(Event* evt){
+    place(evt, _count);
+    _count++;
+    siftUp(evt->index);
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::heapRemove(Event* evt){
+    uint16_t i = (uint16_t)evt->index;
+    evt->index = -1;
+    _count--;
+    if(i == _count){
+        return;
+    }
+    // el último elemento ocupa el hueco y se recoloca hacia arriba o hacia abajo
+    place(_heap[_count], i);
+    if(i > 0 && before(_heap[i]->deadline, _heap[(i-1)/2]->deadline)){
+        siftUp(i);
+    }
+    else{
+        siftDown(i);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::siftUp(uint16_t i){
+    Event* evt = _heap[i];
+    while(i > 0){
+        uint16_t parent = (i-1)/2;
+        if(!before(evt->deadline, _heap[parent]->deadline)){
+            break;
+        }
+        place(_heap[parent], i);
+        i = parent;
+    }
+    place(evt, i);
+}
+
+
+//------------------------------------------------------------------------------------
+void LedScheduler::siftDown(uint16_t i){
+    Event* evt = _heap[i];
+    for(;;){
+        uint16_t child = (2*i)+1;
+        if(child >= _count){
+            break;
+        }
+        if((child+1) < _count && before(_heap[child+1]->deadline, _heap[child]->deadline)){
+            child++;
+        }
+        if(!before(_heap[child]->deadline, evt->deadline)){
+            break;
+        }
+        place(_heap[child], i);
+        i = child;
+    }
+    place(evt, i);
+}
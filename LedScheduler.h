@@ -0,0 +1,295 @@
+/*
+ * LedScheduler.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedScheduler es el planificador compartido por todos los objetos Led. Utiliza un único Ticker y un montículo
+ *  binario (min-heap) de eventos ordenados por su deadline absoluto, de forma que la inserción y la cancelación
+ *  de un evento son O(log n) y la interrupción del timer ejecuta en una única pasada todos los eventos vencidos.
+ *  Las acciones diferidas (ver defer) se ejecutan una sola vez al finalizar la pasada, tras todos los eventos.
+ *
+ *  Cada evento puede admitir una tolerancia (slack): puede ejecutarse hasta slack us después de su deadline.
+ *  El timer se arma en el menor instante límite (deadline + slack) de los eventos pendientes y la pasada
+ *  ejecuta todos los eventos cuyo deadline ya ha vencido, de forma que los eventos con ventanas solapadas se
+ *  agrupan en un único despertar. Los eventos nunca se ejecutan antes de su deadline y los leds encadenan
+ *  deadlines absolutos, por lo que la tolerancia no acumula deriva.
+ *
+ */
+
+#ifndef __LedScheduler__H
+#define __LedScheduler__H
+
+#include "mbed.h"
+#include "LedStats.h"
+
+class LedCommandQueue;
+
+
+class LedScheduler{
+  public:
+
+    /** Evento planificable. Cada Led contiene sus propios eventos (no se reserva memoria al planificar) */
+    struct Event{
+        Callback<void()> cb;                                /// Callback a ejecutar en el vencimiento
+        uint32_t deadline;                                  /// Instante de vencimiento en us (base de tiempos del planificador)
+        uint32_t slack;                                     /// Tolerancia en us: retraso admitido para agruparse con otros eventos
+        int32_t index;                                      /// Posición en el montículo (-1 si no está planificado)
+
+        Event() : deadline(0), slack(0), index(-1) {}
+    };
+
+    /** Acción diferida al final de la pasada en curso. Cada objeto contiene la suya (lista intrusiva) */
+    struct Deferred{
+        Callback<void()> cb;                                /// Callback a ejecutar al final de la pasada
+        Deferred* next;                                     /// Siguiente acción de la lista
+        bool queued;                                        /// Flag para indicar que está en la lista
+
+        Deferred() : next(NULL), queued(false) {}
+    };
+
+    static const uint16_t DefaultMaxEvents = 256;           /// Nº máximo de eventos pendientes por defecto
+
+
+	/** Constructor
+     *  @param max_events Número máximo de eventos pendientes simultáneamente
+     */
+    LedScheduler(uint16_t max_events = DefaultMaxEvents);
+
+
+	/** Constructor con almacenamiento externo (sin memoria dinámica)
+     *  @param storage Array de max_events punteros a evento
+     *  @param max_events Número máximo de eventos pendientes simultáneamente
+     */
+    LedScheduler(Event** storage, uint16_t max_events);
+    ~LedScheduler();
+
+
+	/** getDefault
+     *  Obtiene el planificador compartido por defecto, creándolo en el primer uso. Su montículo reside en
+     *  memoria estática (DefaultMaxEvents eventos, sin memoria dinámica): para más leds se debe utilizar un
+     *  LedSchedulerT de mayor capacidad o un planificador con montículo dinámico
+     *  @return Planificador por defecto
+     */
+    static LedScheduler* getDefault();
+
+
+	/** now
+     *  Obtiene el instante actual en la base de tiempos del planificador
+     *  @return Tiempo en microsegundos (con desbordamiento circular de 32 bits)
+     */
+    uint32_t now();
+
+
+	/** schedule
+     *  Planifica un evento relativo al instante actual. Si el evento ya estaba planificado, se reprograma.
+     *  Se aplica la tolerancia establecida en evt->slack
+     *  @param evt Evento a planificar
+     *  @param cb Callback a ejecutar
+     *  @param delay_us Retardo en microsegundos
+	 *  @return 0 OK, -1 Error (sin espacio)
+     */
+    int schedule(Event* evt, Callback<void()> cb, uint32_t delay_us);
+
+
+	/** scheduleAt
+     *  Planifica un evento en un instante absoluto. Si el evento ya estaba planificado, se reprograma.
+     *  @param evt Evento a planificar
+     *  @param cb Callback a ejecutar
+     *  @param deadline_us Instante absoluto en microsegundos
+	 *  @return 0 OK, -1 Error (sin espacio)
+     */
+    int scheduleAt(Event* evt, Callback<void()> cb, uint32_t deadline_us);
+
+
+	/** cancel
+     *  Cancela un evento planificado. No hace nada si el evento no estaba planificado.
+     *  @param evt Evento a cancelar
+     */
+    void cancel(Event* evt);
+
+
+	/** isScheduled
+     *  Indica si un evento está pendiente de ejecución
+     *  @param evt Evento
+     *  @return true si está planificado
+     */
+    static bool isScheduled(const Event* evt) { return (evt->index >= 0); }
+
+
+	/** reserve
+     *  Reserva espacio en el montículo para los eventos de un objeto (Led, ColorLed, LedGroup, LedBam). Si el
+     *  montículo se reservó dinámicamente, se amplía cuando las reservas superan su capacidad. Con
+     *  almacenamiento externo sólo se comprueba la capacidad: si no es suficiente la reserva no se admite, y
+     *  las planificaciones que no caben fallan y se contabilizan en LedSchedulerStats::arm_failures
+     *  @param events Nº de eventos del objeto
+	 *  @return 0 OK, -1 Error (capacidad insuficiente)
+     */
+    int reserve(uint16_t events);
+
+
+	/** release
+     *  Libera una reserva de eventos (el montículo no se reduce)
+     *  @param events Nº de eventos del objeto
+     */
+    void release(uint16_t events);
+
+
+	/** capacity
+     *  @return Nº máximo de eventos pendientes simultáneamente
+     */
+    uint16_t capacity() const { return _max_events; }
+
+
+	/** defer
+     *  Difiere una acción hasta el final de la pasada en curso. Fuera de una pasada se ejecuta inmediatamente.
+     *  Una acción que ya está en la lista no se vuelve a añadir: varias solicitudes en la misma pasada se
+     *  agrupan en una única ejecución
+     *  @param d Acción
+     *  @param cb Callback a ejecutar
+     *  @return true si se ha diferido (o ya estaba diferida), false si se ha ejecutado inmediatamente
+     */
+    bool defer(Deferred* d, Callback<void()> cb);
+
+
+	/** undefer
+     *  Retira una acción diferida sin ejecutarla. No hace nada si no estaba en la lista
+     *  @param d Acción
+     */
+    void undefer(Deferred* d);
+
+
+	/** pending
+     *  Obtiene el nº de eventos pendientes
+     *  @return Nº de eventos
+     */
+    uint16_t pending() const { return _count; }
+
+
+	/** attachQueue
+     *  Instala una cola de comandos. Con la cola instalada, la API de los leds de este planificador encola
+     *  comandos que se aplican en el contexto del timer (ver LedCommandQueue)
+     *  @param queue Cola de comandos (NULL: los comandos se aplican en el contexto del llamante)
+     */
+    void attachQueue(LedCommandQueue* queue) { _queue = queue; }
+
+
+	/** getQueue
+     *  @return Cola de comandos instalada o NULL
+     */
+    LedCommandQueue* getQueue() const { return _queue; }
+
+
+	/** wakeup
+     *  Solicita una pasada del planificador lo antes posible para aplicar los comandos encolados. Las
+     *  solicitudes consecutivas se agrupan hasta que se ejecuta la pasada
+     */
+    void wakeup();
+
+
+	/** getLateness
+     *  Obtiene el retraso del evento en ejecución respecto a su deadline (válido dentro de su callback)
+     *  @return Retraso en microsegundos
+     */
+    uint32_t getLateness() const { return _late; }
+
+
+	/** getStats
+     *  Obtiene una instantánea de las estadísticas del planificador sin bloquear al timer
+     *  @param stats Recibe las estadísticas
+	 *  @return 0 OK, -1 Error (actualización en curso, reintentar)
+     */
+    int getStats(LedSchedulerStats& stats) const { return _stats_lock.read(stats, _stats); }
+
+
+  private:
+    static const uint32_t MinDelayUs = 1;                   /// Retardo mínimo al rearmar el timer
+    static const uint8_t MaxWakeScan = 16;                  /// Nº máximo de eventos evaluados al rearmar (en sección crítica)
+    static const uint8_t MaxHeapDepth = 17;                 /// Profundidad máxima del montículo (capacidad de 16 bits)
+
+    Event** _heap;                                          /// Montículo de eventos ordenado por deadline
+    bool _owns_heap;                                        /// Flag para indicar si el montículo se reservó dinámicamente
+    uint16_t _count;                                        /// Nº de eventos pendientes
+    uint16_t _max_events;                                   /// Capacidad del montículo
+    uint32_t _reserved;                                     /// Nº de eventos reservados
+    Timer _timer;                                           /// Base de tiempos
+    Ticker _tick;                                           /// Único timer hardware compartido
+    bool _dispatching;                                      /// Flag para indicar que se están ejecutando eventos
+    bool _armed;                                            /// Flag para indicar si el timer está armado
+    uint32_t _armed_deadline;                               /// Instante para el que se armó el timer
+    LedCommandQueue* _queue;                                /// Cola de comandos (opcional)
+    Event _ev_wake;                                         /// Evento para aplicar los comandos encolados
+    volatile uint32_t _wake_pending;                        /// Flag para indicar que hay una pasada solicitada
+    Deferred* _deferred;                                    /// Acciones diferidas al final de la pasada
+    Deferred** _deferred_tail;                              /// Final de la lista de acciones diferidas
+    uint32_t _late;                                         /// Retraso del evento en ejecución
+    LedSchedulerStats _stats;                               /// Estadísticas
+    LedSeqLock _stats_lock;                                 /// Publicación de las estadísticas
+
+
+	/** before
+     *  Comparación de instantes teniendo en cuenta el desbordamiento
+     *  @return true si a es anterior a b
+     */
+    static bool before(uint32_t a, uint32_t b) { return ((int32_t)(a - b) < 0); }
+
+
+	/** isrCb
+     *  Callback del timer. Ejecuta todos los eventos vencidos y rearma el timer
+     */
+    void isrCb();
+
+
+	/** wakeCb
+     *  Callback para aplicar los comandos encolados
+     */
+    void wakeCb();
+
+
+	/** rearm
+     *  Arma el timer en el menor instante límite (deadline + slack) de los eventos pendientes, o lo detiene
+     *  si no hay ninguno
+     */
+    void rearm();
+
+
+	/** wakeTime
+     *  Obtiene el menor instante límite de los eventos del montículo. El recorrido es iterativo y sólo desciende
+     *  por los eventos con deadline anterior al límite encontrado (el resto del subárbol no puede adelantarlo).
+     *  Tras evaluar MaxWakeScan eventos, los subárboles pendientes se acotan por el deadline de su raíz: el
+     *  timer puede despertar antes de lo necesario, nunca después del límite de un evento
+     *  @return Menor instante límite (o una cota anterior)
+     */
+    uint32_t wakeTime() const;
+
+
+	/** Operaciones sobre el montículo (ejecutar en sección crítica) */
+    void heapInsert(Event* evt);
+    void heapRemove(Event* evt);
+    void siftUp(uint16_t i);
+    void siftDown(uint16_t i);
+    void place(Event* evt, uint16_t i) { _heap[i] = evt; evt->index = (int32_t)i; }
+    void init();
+};
+
+
+
+/** LedSchedulerT
+ *  Planificador con el montículo alojado en el propio objeto
+ *  @param MaxEvents Número máximo de eventos pendientes simultáneamente
+ */
+template<uint16_t MaxEvents>
+class LedSchedulerT : public LedScheduler{
+  public:
+    LedSchedulerT() : LedScheduler(_storage, MaxEvents) {}
+  private:
+    Event* _storage[MaxEvents];                             /// Almacenamiento del montículo
+};
+
+
+
+#endif /*__LedScheduler__H */
+
+/**** END OF FILE ****/
+
+
@@ -0,0 +1,105 @@
+/*
+ * LedState.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedState.h"
+#include "Led.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedStateTable::LedStateTable(LedState* storage, Led** owners, uint16_t capacity){
+    _entries = storage;
+    _owners = owners;
+    _capacity = capacity;
+    _count = 0;
+    for(uint16_t i=0;i<_capacity;i++){
+        _owners[i] = NULL;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+LedStateTable::~LedStateTable(){
+    for(uint16_t i=0;i<_count;i++){
+        if(_owners[i] != NULL){
+            detach(_owners[i]);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+int LedStateTable::attach(Led* led){
+    core_util_critical_section_enter();
+    if(led->_state_table != NULL){
+        int rc = (led->_state_table == this)? 0 : -1;
+        core_util_critical_section_exit();
+        return rc;
+    }
+    // reutiliza la primera entrada libre
+    uint16_t i = 0;
+    while(i < _count && _owners[i] != NULL){
+        i++;
+    }
+    if(i >= _capacity){
+        core_util_critical_section_exit();
+        return -1;
+    }
+    _owners[i] = led;
+    // la entrada parte del último estado publicado por el led
+    _lock.writeBegin();
+    led->fillState(_entries[i]);
+    _count = (i == _count)? (_count + 1) : _count;
+    _lock.writeEnd();
+    led->_state = &_entries[i];
+    led->_state_table = this;
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int LedStateTable::detach(Led* led){
+    core_util_critical_section_enter();
+    if(led->_state_table != this){
+        core_util_critical_section_exit();
+        return -1;
+    }
+    uint16_t i = (uint16_t)(led->_state - _entries);
+    led->_state = NULL;
+    led->_state_table = NULL;
+    _owners[i] = NULL;
+    _lock.writeBegin();
+    _entries[i].mode = LedState::ModeNone;
+    _entries[i].flags = 0;
+    // las entradas libres del final dejan de copiarse en las instantáneas
+    while(_count > 0 && _owners[_count - 1] == NULL){
+        _count--;
+    }
+    _lock.writeEnd();
+    core_util_critical_section_exit();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int LedStateTable::snapshot(LedState* dst, uint16_t max) const{
+    uint16_t count = _count;
+    if(count > max){
+        return -1;
+    }
+    // una única copia de todas las entradas: el contador de secuencia es común a la tabla
+    if(_lock.read(dst, _entries, count * sizeof(LedState)) != 0){
+        return -1;
+    }
+    return count;
+}
+
@@ -0,0 +1,155 @@
+/*
+ * LedState.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Estado observable de los leds: modo, intensidad actual y de destino, posición en el patrón e instante del
+ *  próximo cambio de la salida. Puede consultarse desde cualquier contexto sin que el llamante tenga que
+ *  replicar las órdenes (ver Led::getState): sin tabla, el led lo obtiene bajo demanda en una sección crítica
+ *  breve y no ocupa memoria en el objeto.
+ *
+ *  LedStateTable reúne el estado de muchos leds en un array contiguo protegido por un único contador de
+ *  secuencia (LedSeqLock): los leds asociados publican directamente en su entrada de la tabla al finalizar
+ *  cada orden y cada callback, de forma que su estado se lee sin deshabilitar las interrupciones y una
+ *  instantánea de toda la tabla es una única copia de memoria.
+ *
+ *  Ej. de uso:
+ *      static LedStateTableT<64> states;
+ *      ...
+ *      states.attach(&red);
+ *      states.attach(&green);
+ *      ...
+ *      LedState snap[64];
+ *      int n = states.snapshot(snap, 64);
+ *      uint32_t now = LedScheduler::getDefault()->now();
+ *      for(int i=0;i<n;i++){
+ *          printf("led %u modo %u quedan %uus\n", snap[i].id, snap[i].mode, snap[i].timeToEdge(now));
+ *      }
+ *
+ */
+
+#ifndef __LedState__H
+#define __LedState__H
+
+#include "mbed.h"
+#include "LedStats.h"
+
+class Led;
+
+
+/** Estado publicado por un led */
+struct LedState{
+    /** Modo (mismo orden que el estado interno de Led) */
+    enum Mode{
+        ModeOff,
+        ModeOn,
+        ModeBlinking,
+        ModePlaying,
+        ModeGrouped,            /// Salida gestionada por un LedGroup
+        ModeNone,               /// Entrada libre de una LedStateTable
+    };
+
+    /** Flags */
+    enum Flags{
+        FlagEdge = (1 << 0),    /// next_edge contiene el instante del próximo cambio
+        FlagRamp = (1 << 1),    /// Rampa en curso hacia target
+    };
+
+    uint32_t id;                                            /// Led id (PinName32 asociado)
+    uint32_t next_edge;                                     /// Instante absoluto del próximo cambio de la salida (base de tiempos del planificador)
+    uint16_t intensity;                                     /// Intensidad actual (Q16)
+    uint16_t target;                                        /// Intensidad de destino de la rampa en curso (sin rampa: intensity)
+    uint16_t pattern_pc;                                    /// Siguiente instrucción del patrón en ejecución (ModePlaying)
+    uint8_t mode;                                           /// Modo (Mode)
+    uint8_t layer;                                          /// Capa visible (Led::LedLayer)
+    uint8_t flags;                                          /// Flags (Flags)
+
+
+	/** timeToEdge
+     *  Obtiene el tiempo restante hasta el próximo cambio de la salida
+     *  @param now Instante actual (base de tiempos del planificador)
+     *  @return Microsegundos (0 si no hay cambio previsto o ya ha vencido)
+     */
+    uint32_t timeToEdge(uint32_t now) const {
+        return ((flags & FlagEdge) && (int32_t)(next_edge - now) > 0)? (next_edge - now) : 0;
+    }
+};
+
+
+
+class LedStateTable{
+  public:
+
+	/** Constructor
+     *  @param storage Array de capacity entradas
+     *  @param owners Array de capacity punteros a led (led asociado a cada entrada)
+     *  @param capacity Nº máximo de leds
+     */
+    LedStateTable(LedState* storage, Led** owners, uint16_t capacity);
+    ~LedStateTable();
+
+
+	/** attach
+     *  Asocia un led a la tabla. A partir de ese momento el led publica su estado en su entrada. Las entradas
+     *  liberadas con detach se reutilizan
+     *  @param led Led
+	 *  @return 0 OK, -1 Error (tabla llena o led asociado a otra tabla)
+     */
+    int attach(Led* led);
+
+
+	/** detach
+     *  Desasocia un led de la tabla. Su entrada queda libre (ModeNone) y el led deja de publicar su estado
+     *  @param led Led
+	 *  @return 0 OK, -1 Error (no está asociado a esta tabla)
+     */
+    int detach(Led* led);
+
+
+	/** snapshot
+     *  Copia las entradas en uso de la tabla (incluidas las libres intermedias, con ModeNone) en una única
+     *  copia de memoria, sin bloquear al timer
+     *  @param dst Destino
+     *  @param max Capacidad del destino
+	 *  @return Nº de entradas copiadas, -1 Error (destino insuficiente o actualización en curso, reintentar)
+     */
+    int snapshot(LedState* dst, uint16_t max) const;
+
+
+	/** size
+     *  @return Nº de entradas en uso (incluidas las libres intermedias)
+     */
+    uint16_t size() const { return _count; }
+
+
+  private:
+    friend class Led;
+
+    LedState* _entries;                                     /// Entradas
+    Led** _owners;                                          /// Led asociado a cada entrada (NULL: libre)
+    uint16_t _count;                                        /// Nº de entradas en uso
+    uint16_t _capacity;                                     /// Capacidad
+    LedSeqLock _lock;                                       /// Publicación de todas las entradas
+};
+
+
+
+/** LedStateTableT
+ *  Tabla con las entradas alojadas en el propio objeto
+ *  @param Capacity Nº máximo de leds
+ */
+template<uint16_t Capacity>
+class LedStateTableT : public LedStateTable{
+  public:
+    LedStateTableT() : LedStateTable(_storage, _owners, Capacity) {}
+  private:
+    LedState _storage[Capacity];                            /// Almacenamiento de las entradas
+    Led* _owners[Capacity];                                 /// Almacenamiento de los leds asociados
+};
+
+
+
+#endif /*__LedState__H */
+
+/**** END OF FILE ****/
@@ -0,0 +1,200 @@
+/*
+ * LedStats.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Estadísticas de ejecución de los leds y del planificador: callbacks ejecutados por tipo, escrituras en la
+ *  salida, retraso de los callbacks respecto a su deadline, duración de cada pasada del planificador y tiempo
+ *  en cada estado. Los contadores se actualizan en el contexto del timer y se leen mediante instantáneas sin
+ *  bloqueos (LedSeqLock): el lector nunca detiene al escritor, sino que repite la copia si coincide con una
+ *  actualización, de forma que una tarea de monitorización puede consultarlas sin alterar las temporizaciones.
+ *
+ *  Las estadísticas propias de cada led son opcionales y residen fuera del objeto (ver Led::attachStats).
+ *
+ *  Ej. de uso:
+ *      static LedStats led_stats;
+ *      led.attachStats(&led_stats);
+ *      ...
+ *      LedStats stats;
+ *      if(led.getStats(stats) == 0){
+ *          printf("blinkCb=%u late_max=%uus\n", stats.callbacks[LedStats::CbBlink], stats.lateness.max);
+ *      }
+ *
+ */
+
+#ifndef __LedStats__H
+#define __LedStats__H
+
+#include "mbed.h"
+
+
+/** Contador de secuencia (seqlock) para publicar datos a lectores sin bloqueos. Las escrituras pueden
+ *  anidarse (una interrupción que actualiza durante la actualización de un hilo en el mismo núcleo): cada
+ *  inicio y fin incrementa el contador y el lector sólo acepta una copia con el contador par y sin cambios */
+class LedSeqLock{
+  public:
+
+    static const uint8_t MaxRetries = 8;                    /// Nº máximo de intentos de lectura
+
+
+    LedSeqLock() : _seq(0) {}
+
+
+	/** writeBegin, writeEnd
+     *  Delimitan una actualización de los datos protegidos
+     */
+    void writeBegin() { core_util_atomic_incr_u32(&_seq, 1); barrier(); }
+    void writeEnd() { barrier(); core_util_atomic_incr_u32(&_seq, 1); }
+
+
+	/** read
+     *  Copia los datos protegidos. Si la copia coincide con una actualización se repite hasta MaxRetries veces
+     *  @param dst Destino
+     *  @param src Datos protegidos
+	 *  @return 0 OK, -1 Error (actualización en curso en todos los intentos)
+     */
+    template<class T>
+    int read(T& dst, const T& src) const{
+        for(uint8_t i=0;i<MaxRetries;i++){
+            uint32_t seq = core_util_atomic_load_u32(&_seq);
+            if(seq & 1){
+                continue;
+            }
+            barrier();
+            dst = src;
+            barrier();
+            if(core_util_atomic_load_u32(&_seq) == seq){
+                return 0;
+            }
+        }
+        return -1;
+    }
+
+
+	/** read
+     *  Igual que read(), copiando un bloque de memoria (ej. un array de entradas en una única copia)
+     *  @param dst Destino
+     *  @param src Datos protegidos
+     *  @param size Tamaño en bytes
+	 *  @return 0 OK, -1 Error (actualización en curso en todos los intentos)
+     */
+    int read(void* dst, const void* src, size_t size) const{
+        for(uint8_t i=0;i<MaxRetries;i++){
+            uint32_t seq = core_util_atomic_load_u32(&_seq);
+            if(seq & 1){
+                continue;
+            }
+            barrier();
+            memcpy(dst, src, size);
+            barrier();
+            if(core_util_atomic_load_u32(&_seq) == seq){
+                return 0;
+            }
+        }
+        return -1;
+    }
+
+
+  private:
+    volatile uint32_t _seq;                                 /// Contador de secuencia (impar: actualización en curso)
+
+    /** Barrera de compilador: impide reordenar los accesos a los datos respecto al contador */
+    static inline void barrier() { __asm__ __volatile__("" ::: "memory"); }
+};
+
+
+
+/** Histograma logarítmico (base 4) de tiempos en microsegundos */
+struct LedHistogram{
+    static const uint8_t Buckets = 8;                       /// [0], [1,4), [4,16), ... [4096, ...)
+
+    uint32_t count[Buckets];                                /// Nº de muestras por intervalo
+    uint32_t max;                                           /// Máximo registrado
+
+    void clear(){
+        for(uint8_t b=0;b<Buckets;b++){
+            count[b] = 0;
+        }
+        max = 0;
+    }
+
+    void add(uint32_t us){
+        uint8_t b = 0;
+        while(b < (Buckets - 1) && us >= (1UL << (2 * b))){
+            b++;
+        }
+        count[b]++;
+        max = (us > max)? us : max;
+    }
+};
+
+
+
+/** Estadísticas de un led (o agregadas de todos los leds, ver Led::getGlobalStats) */
+struct LedStats{
+    /** Tipos de callback */
+    enum CallbackType{
+        CbRamp,
+        CbBlink,
+        CbPattern,
+        CbExpiry,
+        CbCount
+    };
+
+    /** Estados del led (mismo orden que el estado interno de Led) */
+    enum StatType{
+        StatOff,
+        StatOn,
+        StatBlinking,
+        StatPlaying,
+        StatCount
+    };
+
+    uint32_t callbacks[CbCount];                            /// Callbacks ejecutados por tipo
+    uint32_t writes_issued;                                 /// Escrituras realizadas en la salida
+    uint32_t writes_suppressed;                             /// Escrituras evitadas por el registro sombra
+    LedHistogram lateness;                                  /// Retraso de los callbacks respecto a su deadline
+    uint64_t time_us[StatCount];                            /// Tiempo en cada estado (intervalos finalizados)
+    uint8_t stat;                                           /// Estado actual (StatType)
+    uint32_t stat_since;                                    /// Instante de entrada en el estado actual (base de tiempos del planificador)
+
+    void clear(){
+        for(uint8_t i=0;i<CbCount;i++){
+            callbacks[i] = 0;
+        }
+        writes_issued = 0;
+        writes_suppressed = 0;
+        lateness.clear();
+        for(uint8_t i=0;i<StatCount;i++){
+            time_us[i] = 0;
+        }
+        stat = StatOff;
+        stat_since = 0;
+    }
+};
+
+
+
+/** Estadísticas de un planificador */
+struct LedSchedulerStats{
+    uint32_t passes;                                        /// Pasadas ejecutadas (interrupciones del timer)
+    uint32_t events;                                        /// Eventos ejecutados
+    uint32_t arm_failures;                                  /// Planificaciones rechazadas por montículo lleno
+    LedHistogram lateness;                                  /// Retraso de los eventos respecto a su deadline
+    LedHistogram isr_time;                                  /// Duración de cada pasada
+
+    void clear(){
+        passes = 0;
+        events = 0;
+        arm_failures = 0;
+        lateness.clear();
+        isr_time.clear();
+    }
+};
+
+
+
+#endif /*__LedStats__H */
+
+/**** END OF FILE ****/
@@ -0,0 +1,117 @@
+/*
+ * LedStorage.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Construcción de bancos de leds sin memoria dinámica. La configuración de cada led se describe en una tabla
+ *  constexpr (LedConfig) que reside en flash, y LedStorage<N> aloja los objetos Led en memoria estática,
+ *  construyéndolos en su sitio al invocar init().
+ *
+ *  Ej. de uso:
+ *      static constexpr LedConfig led_cfg[] = {
+ *          LedConfig(PA_8, Led::LedOnOffType),
+ *          LedConfig(PA_9, Led::LedDimmableType, Led::OnIsLowLevel, 1, &LedGamma<LedCurveCie1931>::table),
+ *      };
+ *      static LedStorage<2> leds;
+ *      ...
+ *      leds.init(led_cfg, 2);
+ *      leds[1].on(0, 50);
+ *
+ */
+
+#ifndef __LedStorage__H
+#define __LedStorage__H
+
+#include "Led.h"
+
+
+/** Configuración de un led, construible en tiempo de compilación */
+struct LedConfig{
+    PinName32 pin;                                          /// GPIO conectado al led
+    Led::LedType type;                                      /// Tipo de led
+    Led::LedLogicLevel level;                               /// Nivel lógico de activación
+    uint32_t period_ms;                                     /// Periodo del pwm en milisegundos
+    const LedGammaTable* gamma;                             /// Tabla de corrección gamma (NULL: lineal)
+
+    constexpr LedConfig(PinName32 p, Led::LedType t, Led::LedLogicLevel l = Led::OnIsHighLevel, uint32_t per = 1, const LedGammaTable* g = NULL) :
+        pin(p), type(t), level(l), period_ms(per), gamma(g) {}
+};
+
+
+/** LedStorage
+ *  Almacenamiento estático para N objetos Led
+ *  @param N Nº máximo de leds
+ */
+template<uint16_t N>
+class LedStorage{
+  public:
+
+	/** Constructor constexpr: un objeto estático no requiere código de inicialización en el arranque */
+    constexpr LedStorage() : _storage(), _count(0) {}
+
+    ~LedStorage(){
+        deinit();
+    }
+
+
+	/** init
+     *  Construye los leds en su sitio a partir de una tabla de configuración
+     *  @param table Tabla de configuración
+     *  @param count Nº de leds de la tabla
+     *  @param sched Planificador compartido (NULL: planificador por defecto, en memoria estática)
+	 *  @return 0 OK, -1 Error (tabla mayor que N o planificador sin capacidad para todos los leds)
+     */
+    int init(const LedConfig* table, uint16_t count, LedScheduler* sched = NULL){
+        if(_count != 0 || count > N){
+            return -1;
+        }
+        for(uint16_t i=0;i<count;i++){
+            new(&_storage[i]) Led(table[i].pin, table[i].type, table[i].level, table[i].period_ms, table[i].gamma, sched);
+            _count = i + 1;
+            if(!(*this)[i].isReady()){
+                deinit();
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+
+	/** deinit
+     *  Destruye los leds construidos
+     */
+    void deinit(){
+        for(uint16_t i=0;i<_count;i++){
+            (*this)[i].~Led();
+        }
+        _count = 0;
+    }
+
+
+	/** size
+     *  @return Nº de leds construidos
+     */
+    uint16_t size() const { return _count; }
+
+
+	/** Acceso a cada led */
+    Led& operator[](uint16_t i) { return *reinterpret_cast<Led*>(&_storage[i]); }
+
+  private:
+    union Slot{
+        constexpr Slot() : align(0) {}
+        uint8_t raw[sizeof(Led)];
+        void* align;
+        uint64_t align64;
+    };
+    Slot _storage[N];                                       /// Almacenamiento de los objetos Led
+    uint16_t _count;                                        /// Nº de leds construidos
+};
+
+
+
+#endif /*__LedStorage__H */
+
+/**** END OF FILE ****/
+
@@ -0,0 +1,106 @@
+/*
+ * LedTrace.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedTrace.h"
+
+
+LedTraceRecord LedTrace::_ring[LedTrace::Size];
+volatile uint32_t LedTrace::_head = 0;
+volatile bool LedTrace::_enabled = false;
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void LedTrace::enable(bool enabled){
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    if(enabled){
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+#endif
+    _enabled = enabled;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedTrace::clear(){
+    core_util_critical_section_enter();
+    _head = 0;
+    for(uint32_t i=0;i<Size;i++){
+        _ring[i].seq = InvalidSeq;
+    }
+    core_util_critical_section_exit();
+}
+
+
+//------------------------------------------------------------------------------------
+uint32_t LedTrace::dump(void* buf, uint32_t size){
+    if(buf == NULL || size < sizeof(LedTraceHeader)){
+        return 0;
+    }
+    uint8_t* dst = (uint8_t*)buf + sizeof(LedTraceHeader);
+    uint32_t max_records = (size - sizeof(LedTraceHeader)) / sizeof(LedTraceRecord);
+    uint32_t head = core_util_atomic_load_u32(&_head);
+    uint32_t first = (head > Size)? (head - Size) : 0;
+    uint32_t count = 0;
+    for(uint32_t seq = first; seq != head && count < max_records; seq++){
+        const LedTraceRecord& src = _ring[seq & (Size - 1)];
+        if(core_util_atomic_load_u32(&src.seq) != seq){
+            continue;
+        }
+        barrier();
+        LedTraceRecord r;
+        r.seq = seq;
+        r.ticks = src.ticks;
+        r.id = src.id;
+        r.event = src.event;
+        r.aux = src.aux;
+        r.arg = src.arg;
+        barrier();
+        // el hueco se ha reutilizado durante la copia (o aún se está escribiendo): se descarta
+        if(core_util_atomic_load_u32(&src.seq) != seq){
+            continue;
+        }
+        memcpy(dst, (const void*)&r, sizeof(r));
+        dst += sizeof(r);
+        count++;
+    }
+    LedTraceHeader hdr;
+    hdr.magic = Magic;
+    hdr.version = Version;
+    hdr.record_size = sizeof(LedTraceRecord);
+    hdr.tick_hz = getTickHz();
+    hdr.count = count;
+    hdr.lost = first;
+    memcpy(buf, &hdr, sizeof(hdr));
+    return sizeof(LedTraceHeader) + (count * sizeof(LedTraceRecord));
+}
+
+
+//------------------------------------------------------------------------------------
+const char* LedTrace::getEventName(uint8_t event){
+    static const char* const names[EvCount] = {
+        "on", "off", "blink", "setBlinkMode", "play", "cancelBlinkMode",
+        "rampCb", "blinkCb", "expiryCb", "patternCb", "write"
+    };
+    return (event < EvCount)? names[event] : "?";
+}
+
+
+//------------------------------------------------------------------------------------
+uint32_t LedTrace::getTickHz(){
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    return SystemCoreClock;
+#else
+    return 1000000;
+#endif
+}
+
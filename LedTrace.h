@@ -0,0 +1,198 @@
+/*
+ * LedTrace.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedTrace es un registro de trazas de bajo coste para diagnosticar en campo el estado de los leds. Cada
+ *  llamada a la API (on, off, blink, setBlinkMode, play...), cada callback (rampa, parpadeo, expiración,
+ *  patrón) y cada escritura en la salida se registran con una marca de tiempo del contador de ciclos y el id
+ *  del led, en un buffer circular de tamaño fijo sin bloqueos: el hueco se reserva con un incremento atómico,
+ *  de forma que pueden registrar simultáneamente hilos e interrupciones, y al llenarse se sobrescriben las
+ *  trazas más antiguas.
+ *
+ *  Activación en compilación con LED_TRACE_ENABLED (sin la macro, LED_TRACE no genera código) y en ejecución
+ *  con LedTrace::enable(). El tamaño del buffer se fija con LED_TRACE_SIZE (potencia de 2, por defecto 256).
+ *
+ *  dump() vuelca las trazas en un formato binario compacto (cabecera LedTraceHeader seguida de registros
+ *  LedTraceRecord, de la más antigua a la más reciente) que la herramienta de host test/host/trace_decode
+ *  convierte en una línea de tiempo.
+ *
+ *  Ej. de uso:
+ *      LedTrace::enable(true);
+ *      ...
+ *      static uint8_t buf[LedTrace::DumpMaxSize];
+ *      uint32_t size = LedTrace::dump(buf, sizeof(buf));
+ *      // enviar buf (size bytes) por el canal de depuración
+ *
+ */
+
+#ifndef __LedTrace__H
+#define __LedTrace__H
+
+#include "mbed.h"
+
+#if !defined(LED_TRACE_SIZE)
+#define LED_TRACE_SIZE  256
+#endif
+
+#if defined(LED_TRACE_ENABLED)
+#define LED_TRACE(...)              LedTrace::record(__VA_ARGS__)
+#else
+#define LED_TRACE(...)
+#endif
+
+
+/** Registro de traza (16 bytes) */
+struct LedTraceRecord{
+    volatile uint32_t seq;                                  /// Nº de secuencia (detecta registros sobrescritos durante el volcado)
+    uint32_t ticks;                                         /// Marca de tiempo (contador de ciclos)
+    uint32_t id;                                            /// Id del led (PinName32)
+    uint8_t event;                                          /// Evento (LedTrace::Event)
+    uint8_t aux;                                            /// Argumento auxiliar del evento
+    uint16_t arg;                                           /// Argumento del evento
+};
+
+
+/** Cabecera del volcado binario */
+struct LedTraceHeader{
+    uint32_t magic;                                         /// LedTrace::Magic
+    uint16_t version;                                       /// LedTrace::Version
+    uint16_t record_size;                                   /// sizeof(LedTraceRecord)
+    uint32_t tick_hz;                                       /// Frecuencia de la marca de tiempo
+    uint32_t count;                                         /// Nº de registros a continuación
+    uint32_t lost;                                          /// Nº de registros sobrescritos antes del volcado
+};
+
+
+
+class LedTrace{
+  public:
+
+    /** Eventos registrados. El argumento depende del evento */
+    enum Event{
+        EvOn,                                               /// on(): intensidad (Q16), aux: capa
+        EvOff,                                              /// off(): intensidad (Q16), aux: capa
+        EvBlink,                                            /// blink(): intensidad de encendido (Q16), aux: capa
+        EvSetBlinkMode,                                     /// setBlinkMode(): nº de temporizaciones
+        EvPlay,                                             /// play(): capa
+        EvCancelBlinkMode,                                  /// cancelBlinkMode()
+        EvRampCb,                                           /// Callback de la rampa: intensidad (Q16)
+        EvBlinkCb,                                          /// Callback del parpadeo: intensidad (Q16)
+        EvExpiryCb,                                         /// Callback de expiración de capas: capa visible
+        EvPatternCb,                                        /// Callback del patrón: intensidad (Q16)
+        EvWrite,                                            /// Escritura en la salida: intensidad (Q16)
+        EvCount
+    };
+
+    static const uint32_t Size = LED_TRACE_SIZE;            /// Nº de registros del buffer circular
+    static const uint32_t Magic = 0x5444454CUL;             /// "LEDT"
+    static const uint16_t Version = 2;
+    static const uint32_t DumpMaxSize = sizeof(LedTraceHeader) + (Size * sizeof(LedTraceRecord));
+    static const uint32_t InvalidSeq = 0xFFFFFFFFUL;        /// Nº de secuencia de un hueco vacío o en escritura
+
+
+	/** enable
+     *  Activa o desactiva el registro en ejecución (por defecto desactivado). Al activarlo se inicia el
+     *  contador de ciclos si el núcleo dispone de él
+     *  @param enabled Flag de activación
+     */
+    static void enable(bool enabled);
+
+
+	/** isEnabled
+     *  @return true si el registro está activo
+     */
+    static bool isEnabled() { return _enabled; }
+
+
+	/** record
+     *  Registra un evento (desde cualquier contexto, incluidas interrupciones)
+     *  @param event Evento
+     *  @param id Id del led
+     *  @param arg Argumento del evento
+     *  @param aux Argumento auxiliar del evento
+     */
+    static inline void record(uint8_t event, uint32_t id, uint16_t arg, uint8_t aux = 0){
+        if(!_enabled){
+            return;
+        }
+        // reserva atómica del hueco: un registro interrumpido por otro ocupa huecos distintos
+        uint32_t seq = core_util_atomic_incr_u32(&_head, 1) - 1;
+        LedTraceRecord& r = _ring[seq & (Size - 1)];
+        // el hueco se invalida antes de escribir los campos: un volcado concurrente no lo confunde con el
+        // registro anterior del mismo hueco
+        core_util_atomic_store_u32(&r.seq, InvalidSeq);
+        barrier();
+        r.ticks = ticks();
+        r.id = id;
+        r.event = event;
+        r.aux = aux;
+        r.arg = arg;
+        barrier();
+        // el nº de secuencia se publica el último: valida el registro
+        core_util_atomic_store_u32(&r.seq, seq);
+    }
+
+
+	/** clear
+     *  Descarta todos los registros
+     */
+    static void clear();
+
+
+	/** dump
+     *  Vuelca los registros en formato binario (cabecera y registros de más antiguo a más reciente). Los
+     *  registros sobrescritos durante el volcado se descartan
+     *  @param buf Buffer destino
+     *  @param size Tamaño del buffer (DumpMaxSize para el buffer completo)
+     *  @return Nº de bytes escritos (0 si el buffer no admite la cabecera)
+     */
+    static uint32_t dump(void* buf, uint32_t size);
+
+
+	/** getEventName
+     *  @param event Evento
+     *  @return Nombre del evento
+     */
+    static const char* getEventName(uint8_t event);
+
+
+	/** getTickHz
+     *  @return Frecuencia de la marca de tiempo
+     */
+    static uint32_t getTickHz();
+
+
+  private:
+    static LedTraceRecord _ring[Size];                      /// Buffer circular
+    static volatile uint32_t _head;                         /// Nº de registros realizados (siguiente hueco)
+    static volatile bool _enabled;                          /// Flag de activación
+
+
+	/** ticks
+     *  Lee el contador de ciclos (DWT en Cortex-M3/M4/M7; en otro caso el ticker de microsegundos)
+     */
+    static inline uint32_t ticks(){
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+        return DWT->CYCCNT;
+#else
+        return us_ticker_read();
+#endif
+    }
+
+
+	/** barrier
+     *  Impide que el compilador reordene los accesos a los campos respecto al nº de secuencia
+     */
+    static inline void barrier() { __asm__ __volatile__("" ::: "memory"); }
+};
+
+
+static_assert((LedTrace::Size & (LedTrace::Size - 1)) == 0, "LED_TRACE_SIZE debe ser potencia de 2");
+
+
+
+#endif /*__LedTrace__H */
+
+/**** END OF FILE ****/
@@ -0,0 +1,240 @@
+/*
+ * LedWaveform.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "LedWaveform.h"
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+LedWaveform::LedWaveform(LedWaveSink* sink, uint16_t* storage, uint16_t capacity, uint32_t period_us, Led::LedLogicLevel level, const LedGammaTable* gamma){
+    _sink = sink;
+    _buf[0] = storage;
+    _buf[1] = storage + capacity;
+    _capacity = capacity;
+    _back = 0;
+    _count = 0;
+    _period_us = (period_us == 0)? 1000 : ((period_us > 0xFFFF)? 0xFFFF : period_us);
+    _pulse_fn = (level == Led::OnIsHighLevel)? &LedPwmOutput::pulse<LedActiveHigh> : &LedPwmOutput::pulse<LedActiveLow>;
+    _gamma = gamma;
+    _level = 0;
+    _source.kind = KindNone;
+    _source.ref = NULL;
+    _renders = 0;
+}
+
+
+//------------------------------------------------------------------------------------
+LedWaveform::~LedWaveform(){
+    LedPatternRegistry::getDefault()->release((LedPatternHandle)_source.ref);
+}
+
+
+//------------------------------------------------------------------------------------
+int LedWaveform::renderLevel(uint16_t level){
+    Source src = {KindLevel, level, 0, 0, 0, NULL};
+    int rc = begin(src);
+    if(rc <= 0){
+        return rc;
+    }
+    fill(0, 1, level);
+    commit(src, 1, false, level);
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int LedWaveform::renderBlink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint16_t intensity_on, uint16_t intensity_off){
+    uint32_t on = toPeriods(ms_blink_on);
+    uint32_t total = on + toPeriods(ms_blink_off);
+    if(total == 0 || total > _capacity){
+        return -1;
+    }
+    Source src = {KindBlink, intensity_on, intensity_off, ms_blink_on, ms_blink_off, NULL};
+    int rc = begin(src);
+    if(rc <= 0){
+        return rc;
+    }
+    fill(0, on, intensity_on);
+    fill(on, total, intensity_off);
+    commit(src, (uint16_t)total, true, intensity_off);
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int LedWaveform::renderRamp(uint16_t target, uint32_t ms_ramp, LedEasing curve){
+    // un periodo final con el destino exacto, que la salida mantiene al finalizar
+    uint32_t total = toPeriods(ms_ramp) + 1;
+    if(total > _capacity){
+        return -1;
+    }
+    Source src = {KindRamp, target, 0, ms_ramp, (uint32_t)curve, NULL};
+    int rc = begin(src);
+    if(rc <= 0){
+        return rc;
+    }
+    fillRamp(0, _level, target, ms_ramp, LedRamp::getTable(curve));
+    fill(total - 1, total, target);
+    commit(src, (uint16_t)total, false, target);
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+int LedWaveform::renderPattern(LedPatternHandle pattern){
+    if(pattern == NULL || pattern->count == 0){
+        return -1;
+    }
+    Source src = {KindPattern, 0, 0, 0, 0, pattern};
+    int rc = begin(src);
+    if(rc <= 0){
+        return rc;
+    }
+    // un patrón que vuelve al inicio se calcula una única pasada y el destino la repite
+    const LedPatternOp& last = pattern->ops[pattern->count - 1];
+    bool loop = (pattern->count > 1 && last.code == LedPatternOp::OpJump && last.arg16 == 0);
+    LedPattern pass(pattern->ops, loop? (pattern->count - 1) : pattern->count);
+    uint16_t start = _level;
+    uint16_t level = start;
+    uint32_t count = 0;
+    if(!fillPattern(pass, level, count)){
+        return -1;
+    }
+    if(loop){
+        if(count == 0){
+            return -1;
+        }
+        // las pasadas siguientes parten del nivel final: una rampa inicial debe partir de él
+        if(level != start){
+            if(!fillPattern(pass, level, count)){
+                return -1;
+            }
+        }
+    }
+    else{
+        if(count >= _capacity){
+            return -1;
+        }
+        fill(count, count + 1, level);
+        count++;
+    }
+    commit(src, (uint16_t)count, loop, level);
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedWaveform::stop(){
+    _sink->stop();
+    _source.kind = KindNone;
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- PRIVATE METHODS IMPLEMENTATION --------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+int LedWaveform::begin(const Source& src){
+    if(_source.kind != KindNone && src == _source){
+        return 0;
+    }
+    // mientras el destino no adopte el último buffer entregado, sigue transfiriendo el buffer libre
+    if(_sink->isPending()){
+        return -1;
+    }
+    return 1;
+}
+
+
+//------------------------------------------------------------------------------------
+void LedWaveform::commit(const Source& src, uint16_t count, bool loop, uint16_t level){
+    _sink->queue(_buf[_back], count, loop);
+    _back ^= 1;
+    _count = count;
+    _level = level;
+    // la forma de onda en curso mantiene la referencia a su patrón: la entrada no se reutiliza mientras se
+    // compara con las órdenes siguientes
+    LedPatternRegistry::getDefault()->acquire((LedPatternHandle)src.ref);
+    LedPatternRegistry::getDefault()->release((LedPatternHandle)_source.ref);
+    _source = src;
+    _renders++;
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedWaveform::fill(uint32_t from, uint32_t to, uint16_t level){
+    if(to > _capacity){
+        return false;
+    }
+    uint16_t pulse = (uint16_t)_pulse_fn(level, _gamma, _period_us);
+    uint16_t* buf = _buf[_back];
+    for(uint32_t i=from;i<to;i++){
+        buf[i] = pulse;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedWaveform::fillRamp(uint32_t from, uint16_t level0, uint16_t level1, uint32_t ms, const uint16_t* table){
+    uint32_t n = toPeriods(ms);
+    if(from + n > _capacity){
+        return false;
+    }
+    // mismos pasos que la rampa ejecutada por Led, muestreados al inicio de cada periodo
+    LedRamp ramp;
+    ramp.start(level0, level1, ms * 1000, _period_us, table, 0);
+    uint16_t level = level0;
+    uint16_t* buf = _buf[_back];
+    for(uint32_t i=0;i<n;i++){
+        uint32_t t = i * _period_us;
+        while(ramp.isRunning() && (int32_t)(t - ramp.nextDeadline()) >= 0){
+            ramp.step(level);
+        }
+        buf[from + i] = (uint16_t)_pulse_fn(level, _gamma, _period_us);
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------------
+bool LedWaveform::fillPattern(const LedPattern& pattern, uint16_t& level, uint32_t& count){
+    LedPatternCursor cursor;
+    LedPatternOp op;
+    const uint16_t* table = LedRamp::getTable(LedEasingLinear);
+    uint32_t periods = 0;
+    cursor.start(&pattern);
+    while(cursor.next(op)){
+        uint32_t n = toPeriods(op.arg16);
+        if(op.code == LedPatternOp::OpRamp && op.arg16 != 0){
+            uint16_t target = LedPatternOp::toQ16(op.arg8);
+            if(!fillRamp(periods, level, target, op.arg16, table)){
+                return false;
+            }
+            level = target;
+        }
+        else{
+            if(op.code != LedPatternOp::OpHold){
+                level = LedPatternOp::toQ16(op.arg8);
+            }
+            if(!fill(periods, periods + n, level)){
+                return false;
+            }
+        }
+        periods += n;
+    }
+    count = periods;
+    return true;
+}
+
@@ -0,0 +1,242 @@
+/*
+ * LedWaveform.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	LedWaveform precalcula una rampa, un parpadeo o un patrón como una forma de onda: un buffer con el ancho de
+ *  pulso de cada periodo del pwm, con la corrección gamma y el nivel lógico ya aplicados. Un destino
+ *  (LedWaveSink) transfiere el buffer al registro de comparación del timer sin intervención de la CPU en cada
+ *  paso; en el hardware se implementa con un canal DMA en modo doble buffer disparado por el evento de
+ *  actualización del timer.
+ *
+ *  Los buffers son dobles: la forma de onda nueva se calcula en el buffer libre y el destino la adopta al
+ *  final del periodo del buffer en curso, de forma que el cambio no produce saltos. El cálculo es perezoso:
+ *  una orden idéntica a la forma de onda en curso no se recalcula.
+ *
+ *  Ej. de uso:
+ *      static MyDmaSink sink(TIM1, 1);                     // LedWaveSink propio de la plataforma
+ *      static LedWaveformT<2000> wave(&sink, 1000);        // hasta 2s de forma de onda con periodo de 1ms
+ *      wave.renderBlink(250, 750, 0xFFFF, 0);
+ *
+ */
+
+#ifndef __LedWaveform__H
+#define __LedWaveform__H
+
+#include "mbed.h"
+#include "Led.h"
+
+
+
+/** Destino de las formas de onda (DMA al registro de comparación del timer, o simulado en el host) */
+class LedWaveSink{
+  public:
+    virtual ~LedWaveSink() {}
+
+
+	/** queue
+     *  Entrega el siguiente buffer. Si hay una transferencia en curso, el destino lo adopta al finalizar el
+     *  buffer actual; si no, comienza en el siguiente periodo. Un buffer cíclico se repite hasta que se
+     *  entrega otro; al finalizar un buffer no cíclico la salida mantiene su último valor
+     *  @param buf Anchos de pulso, uno por periodo del pwm (debe permanecer válido mientras se transfiere)
+     *  @param count Nº de periodos
+     *  @param loop Flag para indicar que el buffer es cíclico
+     */
+    virtual void queue(const uint16_t* buf, uint16_t count, bool loop) = 0;
+
+
+	/** isPending
+     *  @return true si el último buffer entregado aún no se ha adoptado
+     */
+    virtual bool isPending() const = 0;
+
+
+	/** stop
+     *  Detiene la transferencia (la salida mantiene su último valor)
+     */
+    virtual void stop() = 0;
+};
+
+
+
+class LedWaveform{
+  public:
+
+	/** Constructor
+     *  @param sink Destino de las formas de onda
+     *  @param storage Array de 2 * capacity anchos de pulso (doble buffer)
+     *  @param capacity Nº máximo de periodos de una forma de onda
+     *  @param period_us Periodo del pwm en microsegundos (el mismo que el del destino, máximo 65535)
+     *  @param level Nivel de activación lógico
+     *  @param gamma Tabla de corrección gamma (NULL: lineal)
+     */
+    LedWaveform(LedWaveSink* sink, uint16_t* storage, uint16_t capacity, uint32_t period_us, Led::LedLogicLevel level = Led::OnIsHighLevel, const LedGammaTable* gamma = NULL);
+    ~LedWaveform();
+
+
+	/** renderLevel
+     *  Fija una intensidad constante
+     *  @param level Intensidad Q16
+	 *  @return 0 OK, -1 Error (el buffer entregado anteriormente aún no se ha adoptado, reintentar)
+     */
+    int renderLevel(uint16_t level);
+
+
+	/** renderBlink
+     *  Calcula un ciclo de parpadeo (buffer cíclico)
+     *	@param ms_blink_on Tiempo de encendido en ms
+	 *	@param ms_blink_off Tiempo de apagado en ms
+     *  @param intensity_on Intensidad de encendido Q16
+     *  @param intensity_off Intensidad de apagado Q16
+	 *  @return 0 OK, -1 Error (ciclo mayor que la capacidad o buffer anterior pendiente)
+     */
+    int renderBlink(uint32_t ms_blink_on, uint32_t ms_blink_off, uint16_t intensity_on, uint16_t intensity_off);
+
+
+	/** renderRamp
+     *  Calcula una rampa desde la intensidad final de la forma de onda en curso (la salida mantiene el
+     *  destino al finalizar)
+     *  @param target Intensidad final Q16
+     *  @param ms_ramp Duración en ms
+     *  @param curve Curva de transición
+	 *  @return 0 OK, -1 Error (rampa mayor que la capacidad o buffer anterior pendiente)
+     */
+    int renderRamp(uint16_t target, uint32_t ms_ramp, LedEasing curve = LedEasingLinear);
+
+
+	/** renderPattern
+     *  Calcula un patrón compilado. Un patrón que finaliza con jump(0) se calcula una única vez como buffer
+     *  cíclico; un patrón que finaliza con end() mantiene su último nivel
+     *  @param pattern Patrón o handle de LedPatternRegistry
+	 *  @return 0 OK, -1 Error (patrón nulo, mayor que la capacidad o buffer anterior pendiente)
+     */
+    int renderPattern(LedPatternHandle pattern);
+
+
+	/** stop
+     *  Detiene la transferencia. La siguiente orden se recalcula siempre
+     */
+    void stop();
+
+
+	/** getRenders
+     *  @return Nº de formas de onda calculadas (las órdenes idénticas a la forma de onda en curso no cuentan)
+     */
+    uint32_t getRenders() const { return _renders; }
+
+
+	/** getLength
+     *  @return Nº de periodos de la forma de onda en curso
+     */
+    uint16_t getLength() const { return _count; }
+
+
+  private:
+    /** Orden que originó la forma de onda en curso (cálculo perezoso) */
+    struct Source{
+        uint8_t kind;                                       /// Tipo de orden (Kind)
+        uint16_t level0;                                    /// Intensidad (nivel, encendido o destino)
+        uint16_t level1;                                    /// Intensidad de apagado
+        uint32_t ms0;                                       /// Encendido o duración de la rampa
+        uint32_t ms1;                                       /// Apagado o curva de la rampa
+        const void* ref;                                    /// Patrón
+
+        bool operator==(const Source& s) const {
+            return (kind == s.kind && level0 == s.level0 && level1 == s.level1 && ms0 == s.ms0 && ms1 == s.ms1 && ref == s.ref);
+        }
+    };
+    enum Kind{
+        KindNone,
+        KindLevel,
+        KindBlink,
+        KindRamp,
+        KindPattern,
+    };
+
+    LedWaveSink* _sink;                                     /// Destino
+    uint16_t* _buf[2];                                      /// Doble buffer
+    uint16_t _capacity;                                     /// Capacidad de cada buffer
+    uint8_t _back;                                          /// Buffer libre para el siguiente cálculo
+    uint16_t _count;                                        /// Periodos de la forma de onda en curso
+    uint32_t _period_us;                                    /// Periodo del pwm en microsegundos
+    LedPulseFn _pulse_fn;                                   /// Cálculo del ancho de pulso por nivel lógico
+    const LedGammaTable* _gamma;                            /// Tabla de corrección gamma (NULL: lineal)
+    uint16_t _level;                                        /// Intensidad final de la forma de onda en curso (Q16)
+    Source _source;                                         /// Orden de la forma de onda en curso
+    uint32_t _renders;                                      /// Nº de formas de onda calculadas
+
+
+	/** begin
+     *  Comprueba si la orden requiere un cálculo y si el buffer libre está disponible
+     *  @param src Orden
+     *  @return 1 calcular, 0 forma de onda ya en curso, -1 buffer anterior pendiente
+     */
+    int begin(const Source& src);
+
+
+	/** commit
+     *  Entrega el buffer calculado al destino y lo convierte en la forma de onda en curso
+     *  @param src Orden
+     *  @param count Nº de periodos
+     *  @param loop Flag para indicar que es cíclico
+     *  @param level Intensidad final (Q16)
+     */
+    void commit(const Source& src, uint16_t count, bool loop, uint16_t level);
+
+
+	/** fill
+     *  Rellena los periodos [from, to) del buffer libre con una intensidad
+     *  @return false si se supera la capacidad
+     */
+    bool fill(uint32_t from, uint32_t to, uint16_t level);
+
+
+	/** fillRamp
+     *  Rellena los periodos de una rampa que comienza en el periodo from
+     *  @return false si se supera la capacidad
+     */
+    bool fillRamp(uint32_t from, uint16_t level0, uint16_t level1, uint32_t ms, const uint16_t* table);
+
+
+	/** fillPattern
+     *  Rellena los periodos de una pasada de un patrón desde el periodo 0
+     *  @param pattern Patrón
+     *  @param level Intensidad inicial, recibe la intensidad final (Q16)
+     *  @param count Recibe el nº de periodos
+     *  @return false si se supera la capacidad
+     */
+    bool fillPattern(const LedPattern& pattern, uint16_t& level, uint32_t& count);
+
+
+	/** toPeriods
+     *  @return Nº de periodos del pwm transcurridos en ms milisegundos
+     */
+    uint32_t toPeriods(uint32_t ms) const { return (uint32_t)(((uint64_t)ms * 1000) / _period_us); }
+
+
+	/** Objeto no copiable */
+    LedWaveform(const LedWaveform&);
+    LedWaveform& operator=(const LedWaveform&);
+};
+
+
+
+/** LedWaveformT
+ *  LedWaveform con el doble buffer en el propio objeto
+ *  @param Capacity Nº máximo de periodos de una forma de onda
+ */
+template<uint16_t Capacity>
+class LedWaveformT : public LedWaveform{
+  public:
+    LedWaveformT(LedWaveSink* sink, uint32_t period_us, Led::LedLogicLevel level = Led::OnIsHighLevel, const LedGammaTable* gamma = NULL) :
+        LedWaveform(sink, _storage, Capacity, period_us, level, gamma) {}
+  private:
+    uint16_t _storage[2 * Capacity];                        /// Almacenamiento del doble buffer
+};
+
+
+
+#endif /*__LedWaveform__H */
+
+/**** END OF FILE ****/
@@ -0,0 +1,7 @@
+/*
+ * DigitalOut.h
+ *
+ *	Sustituto para el host: la clase DigitalOut se declara en mbed.h
+ */
+
+#include "mbed.h"
@@ -0,0 +1,102 @@
+/*
+ * MockWaveSink.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Sustituto para el host del destino DMA de LedWaveform. Simula la transferencia de un ancho de pulso por
+ *  periodo del pwm con el mismo doble buffer que el DMA: el buffer entregado se adopta al finalizar el buffer
+ *  en curso. Registra el ancho de pulso de cada periodo y el nº de adopciones (interrupciones de fin de
+ *  transferencia en el hardware).
+ *
+ */
+
+#ifndef __MockWaveSink__H
+#define __MockWaveSink__H
+
+#include "LedWaveform.h"
+#include <vector>
+
+
+class MockWaveSink : public LedWaveSink{
+  public:
+    MockWaveSink() : _cur(NULL), _count(0), _pos(0), _loop(false), _next(NULL), _next_count(0), _next_loop(false),
+                     _pending(false), _value(0), _adoptions(0) {}
+
+    virtual void queue(const uint16_t* buf, uint16_t count, bool loop){
+        _next = buf;
+        _next_count = count;
+        _next_loop = loop;
+        _pending = true;
+    }
+
+    virtual bool isPending() const { return _pending; }
+
+    virtual void stop(){
+        _cur = NULL;
+        _pending = false;
+    }
+
+	/** run
+     *  Simula periodos del pwm
+     *  @param periods Nº de periodos
+     */
+    void run(uint32_t periods){
+        for(uint32_t p=0;p<periods;p++){
+            if(_cur != NULL && _pos >= _count){
+                if(_pending){
+                    adopt();
+                }
+                else if(_loop){
+                    _pos = 0;
+                }
+                else{
+                    _cur = NULL;
+                }
+            }
+            if(_cur == NULL && _pending){
+                adopt();
+            }
+            if(_cur != NULL){
+                _value = _cur[_pos++];
+            }
+            _out.push_back(_value);
+        }
+    }
+
+	/** getOutput, clearOutput
+     *  Ancho de pulso de cada periodo simulado
+     */
+    const std::vector<uint16_t>& getOutput() const { return _out; }
+    void clearOutput() { _out.clear(); }
+
+	/** getAdoptions
+     *  @return Nº de buffers adoptados
+     */
+    uint32_t getAdoptions() const { return _adoptions; }
+
+  private:
+    const uint16_t* _cur;
+    uint16_t _count;
+    uint16_t _pos;
+    bool _loop;
+    const uint16_t* _next;
+    uint16_t _next_count;
+    bool _next_loop;
+    bool _pending;
+    uint16_t _value;
+    uint32_t _adoptions;
+    std::vector<uint16_t> _out;
+
+    void adopt(){
+        _cur = _next;
+        _count = _next_count;
+        _loop = _next_loop;
+        _pos = 0;
+        _pending = false;
+        _adoptions++;
+    }
+};
+
+
+#endif /*__MockWaveSink__H */
@@ -0,0 +1,7 @@
+/*
+ * PortOut.h
+ *
+ *	Sustituto para el host: la clase PortOut se declara en mbed.h
+ */
+
+#include "mbed.h"
@@ -0,0 +1,7 @@
+/*
+ * PwmOut.h
+ *
+ *	Sustituto para el host: la clase PwmOut se declara en mbed.h
+ */
+
+#include "mbed.h"
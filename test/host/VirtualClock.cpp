@@ -0,0 +1,207 @@
+/*
+ * VirtualClock.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "mbed.h"
+#include <mutex>
+
+
+//------------------------------------------------------------------------------------
+//--- PRIVATE TYPES ------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+/** Ticker armado */
+struct TickerEntry{
+    Ticker* owner;
+    Callback<void()> cb;
+    uint64_t deadline;
+    uint32_t period_us;
+    uint32_t seq;
+};
+
+static uint64_t s_now = 0;
+static uint32_t s_latency = 0;
+static uint32_t s_seq = 0;
+static bool s_recording = true;
+static uint32_t s_callbacks = 0;
+static uint32_t s_write_count = 0;
+static std::vector<TickerEntry> s_tickers;
+static std::vector<VirtualClock::Write> s_writes;
+static std::vector<uint32_t> s_pin_writes;
+static std::recursive_mutex s_critical;
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+void core_util_critical_section_enter(){
+    s_critical.lock();
+}
+
+
+//------------------------------------------------------------------------------------
+void core_util_critical_section_exit(){
+    s_critical.unlock();
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::reset(){
+    // el tiempo es monotónico y los Tickers pertenecen a objetos vivos: no se modifican
+    s_latency = 0;
+    s_recording = true;
+    clearWrites();
+}
+
+
+//------------------------------------------------------------------------------------
+uint64_t VirtualClock::now(){
+    return s_now;
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::advance(uint64_t us){
+    advanceTo(s_now + us);
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::advanceTo(uint64_t t_us){
+    // los callbacks emulan interrupciones: ningún hilo de la aplicación se ejecuta mientras el reloj avanza
+    std::lock_guard<std::recursive_mutex> isr(s_critical);
+    for(;;){
+        // busca el Ticker con el vencimiento más próximo (a igualdad, el armado antes)
+        int next = -1;
+        for(size_t i=0;i<s_tickers.size();i++){
+            if(s_tickers[i].deadline + s_latency > t_us){
+                continue;
+            }
+            if(next < 0 || s_tickers[i].deadline < s_tickers[next].deadline ||
+              (s_tickers[i].deadline == s_tickers[next].deadline && s_tickers[i].seq < s_tickers[next].seq)){
+                next = (int)i;
+            }
+        }
+        if(next < 0){
+            break;
+        }
+        TickerEntry fired = s_tickers[next];
+        uint64_t t_exec = fired.deadline + s_latency;
+        s_now = (t_exec > s_now)? t_exec : s_now;
+        // los Tickers son periódicos: el siguiente vencimiento se calcula desde el anterior
+        s_tickers[next].deadline += (fired.period_us > 0)? fired.period_us : 1;
+        s_callbacks++;
+        fired.cb.call();
+    }
+    s_now = (t_us > s_now)? t_us : s_now;
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::setLatency(uint32_t us){
+    s_latency = us;
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::setRecording(bool enable){
+    s_recording = enable;
+}
+
+
+//------------------------------------------------------------------------------------
+const std::vector<VirtualClock::Write>& VirtualClock::getWrites(){
+    return s_writes;
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::clearWrites(){
+    s_writes.clear();
+    s_pin_writes.clear();
+    s_write_count = 0;
+    s_callbacks = 0;
+}
+
+
+//------------------------------------------------------------------------------------
+uint32_t VirtualClock::getWriteCount(int pin){
+    if(pin < 0){
+        return s_write_count;
+    }
+    return ((size_t)pin < s_pin_writes.size())? s_pin_writes[pin] : 0;
+}
+
+
+//------------------------------------------------------------------------------------
+const VirtualClock::Write* VirtualClock::getLastWrite(int pin){
+    for(size_t i=s_writes.size();i>0;i--){
+        if(s_writes[i-1].pin == pin){
+            return &s_writes[i-1];
+        }
+    }
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------------
+uint32_t VirtualClock::getCallbackCount(){
+    return s_callbacks;
+}
+
+
+//------------------------------------------------------------------------------------
+uint32_t VirtualClock::getActiveTickers(){
+    return (uint32_t)s_tickers.size();
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::attach(Ticker* owner, const Callback<void()>& cb, uint32_t period_us){
+    detach(owner);
+    TickerEntry e;
+    e.owner = owner;
+    e.cb = cb;
+    e.deadline = s_now + period_us;
+    e.period_us = period_us;
+    e.seq = s_seq++;
+    s_tickers.push_back(e);
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::detach(Ticker* owner){
+    for(size_t i=0;i<s_tickers.size();i++){
+        if(s_tickers[i].owner == owner){
+            s_tickers.erase(s_tickers.begin() + i);
+            return;
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+void VirtualClock::logWrite(int pin, WriteKind kind, int value, int period_us){
+    s_write_count++;
+    if(pin >= 0){
+        if((size_t)pin >= s_pin_writes.size()){
+            s_pin_writes.resize(pin + 1, 0);
+        }
+        s_pin_writes[pin]++;
+    }
+    if(s_recording){
+        Write w;
+        w.t_us = s_now;
+        w.pin = pin;
+        w.kind = kind;
+        w.value = value;
+        w.period_us = period_us;
+        s_writes.push_back(w);
+    }
+}
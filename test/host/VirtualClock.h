@@ -0,0 +1,131 @@
+/*
+ * VirtualClock.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	VirtualClock es el reloj virtual determinista de la HAL de host. Mantiene la lista de Tickers armados,
+ *  los ejecuta en orden de vencimiento cuando el test avanza el tiempo y registra cada escritura en las
+ *  salidas con su marca de tiempo. Permite inyectar una latencia fija de interrupción para medir deriva.
+ *
+ */
+
+#ifndef __VirtualClock__H
+#define __VirtualClock__H
+
+#include <stdint.h>
+#include <vector>
+
+template<typename F> class Callback;
+class Ticker;
+
+
+class VirtualClock{
+  public:
+
+    /** Tipo de escritura registrada */
+    enum WriteKind{
+        DigitalWrite,
+        PwmWrite,
+        PortWrite,
+    };
+
+    /** Registro de una escritura en una salida */
+    struct Write{
+        uint64_t t_us;                                      /// Instante de la escritura
+        int pin;                                            /// Pin de la salida
+        WriteKind kind;                                     /// Tipo de salida
+        int value;                                          /// Valor (0/1, ancho de pulso en us o valor del puerto)
+        int period_us;                                      /// Periodo del pwm (0 en salidas digitales)
+    };
+
+
+	/** reset
+     *  Borra registros, contadores y latencia. El tiempo sigue siendo monotónico y los Tickers armados se mantienen
+     */
+    static void reset();
+
+
+	/** now
+     *  @return Instante actual en microsegundos
+     */
+    static uint64_t now();
+
+
+	/** advance
+     *  Avanza el reloj ejecutando en orden todos los Tickers que vencen en el intervalo
+     *  @param us Microsegundos a avanzar
+     */
+    static void advance(uint64_t us);
+
+
+	/** advanceTo
+     *  Avanza el reloj hasta un instante absoluto
+     *  @param t_us Instante destino
+     */
+    static void advanceTo(uint64_t t_us);
+
+
+	/** setLatency
+     *  Establece la latencia de interrupción: cada callback se ejecuta us microsegundos después de su vencimiento
+     *  @param us Latencia en microsegundos
+     */
+    static void setLatency(uint32_t us);
+
+
+	/** setRecording
+     *  Activa o desactiva el registro de escrituras (los contadores se actualizan siempre)
+     *  @param enable true: registra
+     */
+    static void setRecording(bool enable);
+
+
+	/** getWrites
+     *  @return Escrituras registradas
+     */
+    static const std::vector<Write>& getWrites();
+
+
+	/** clearWrites
+     *  Borra el registro de escrituras y los contadores
+     */
+    static void clearWrites();
+
+
+	/** getWriteCount
+     *  @param pin Pin (-1: todos)
+     *  @return Nº de escrituras realizadas
+     */
+    static uint32_t getWriteCount(int pin = -1);
+
+
+	/** getLastWrite
+     *  @param pin Pin
+     *  @return Última escritura registrada del pin o NULL
+     */
+    static const Write* getLastWrite(int pin);
+
+
+	/** getCallbackCount
+     *  @return Nº de callbacks de Ticker ejecutados desde el último reset
+     */
+    static uint32_t getCallbackCount();
+
+
+	/** getActiveTickers
+     *  @return Nº de Tickers armados
+     */
+    static uint32_t getActiveTickers();
+
+
+	/** Interfaz para la HAL (mbed.h) */
+    static void attach(Ticker* owner, const Callback<void()>& cb, uint32_t period_us);
+    static void detach(Ticker* owner);
+    static void logWrite(int pin, WriteKind kind, int value, int period_us);
+};
+
+
+
+#endif /*__VirtualClock__H */
+
+/**** END OF FILE ****/
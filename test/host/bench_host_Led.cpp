@@ -0,0 +1,691 @@
+/*
+ * bench_host_Led.cpp
+ *
+ *	Benchmark del módulo Driver_Led sobre la HAL de host. Mide el coste de las llamadas de la API, de los
+ *  callbacks del timer, las escrituras por cambio de estado y la memoria por led. Los resultados se emiten
+ *  en formato JSON (un objeto por línea) para poder seguir regresiones.
+ */
+
+
+
+//------------------------------------------------------------------------------------
+//-- BENCH HEADERS -------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+#include "mbed.h"
+#include "Led.h"
+#include "LedBank.h"
+#include "LedWaveform.h"
+#include "MockWaveSink.h"
+#include <stdlib.h>
+#include <new>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+
+//------------------------------------------------------------------------------------
+//-- SPECIFIC COMPONENTS FOR BENCHMARKING --------------------------------------------
+//------------------------------------------------------------------------------------
+
+#define PIN_BENCH				1000
+#define CALL_ITERATIONS			200000
+#define CALLBACK_LEDS			100
+#define CALLBACK_SECONDS		60
+#define QUEUE_POSTS				200000
+#define QUEUE_LEDS				8
+#define BANK_SECONDS			4
+#define BAM_SECONDS				2
+#define PORT_BENCH				2000
+#define SLACK_LEDS				24
+#define SLACK_SECONDS			60
+#define STATE_LEDS				1000
+#define STATE_SNAPSHOTS			2000
+
+/** Contabilidad de memoria dinámica */
+static size_t s_heap_bytes = 0;
+static size_t s_heap_allocs = 0;
+
+__attribute__((noinline)) void* operator new(size_t size){
+    size_t* p = (size_t*)malloc(size + sizeof(size_t));
+    if(p == NULL){
+        throw std::bad_alloc();
+    }
+    p[0] = size;
+    s_heap_bytes += size;
+    s_heap_allocs++;
+    return &p[1];
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept{
+    if(ptr != NULL){
+        size_t* p = ((size_t*)ptr) - 1;
+        s_heap_bytes -= p[0];
+        free(p);
+    }
+}
+
+void* operator new[](size_t size){ return operator new(size); }
+void operator delete[](void* ptr) noexcept{ operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept{ operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept{ operator delete(ptr); }
+
+
+//------------------------------------------------------------------------------------
+static uint64_t wall_ns(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//------------------------------------------------------------------------------------
+static void report(const char* bench, const char* metric, double value, int leds){
+    printf("{\"bench\":\"%s\",\"metric\":\"%s\",\"leds\":%d,\"value\":%.3f}\n", bench, metric, leds, value);
+}
+
+
+//------------------------------------------------------------------------------------
+//-- BENCH FUNCTIONS -----------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+static void bench_api_calls(){
+    const uint32_t blink_sequence[] = {250, 250, 250, 1000};
+    LedScheduler sched;
+    Led led(PIN_BENCH, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+    uint64_t t;
+
+    t = wall_ns();
+    for(int i=0;i<CALL_ITERATIONS;i++){
+        led.on(0, (uint8_t)(i & 63));
+    }
+    report("api", "on_ns_per_call", (double)(wall_ns() - t) / CALL_ITERATIONS, 1);
+
+    t = wall_ns();
+    for(int i=0;i<CALL_ITERATIONS;i++){
+        led.off(0, (uint8_t)(i & 63));
+    }
+    report("api", "off_ns_per_call", (double)(wall_ns() - t) / CALL_ITERATIONS, 1);
+
+    t = wall_ns();
+    for(int i=0;i<CALL_ITERATIONS;i++){
+        led.on(0, 100, 500);
+    }
+    report("api", "on_ramp_ns_per_call", (double)(wall_ns() - t) / CALL_ITERATIONS, 1);
+
+    t = wall_ns();
+    for(int i=0;i<CALL_ITERATIONS;i++){
+        led.blink(250, 250);
+    }
+    report("api", "blink_ns_per_call", (double)(wall_ns() - t) / CALL_ITERATIONS, 1);
+
+    t = wall_ns();
+    for(int i=0;i<CALL_ITERATIONS;i++){
+        led.setBlinkMode(blink_sequence, 4);
+    }
+    report("api", "setBlinkMode_ns_per_call", (double)(wall_ns() - t) / CALL_ITERATIONS, 1);
+
+    static constexpr LedPatternOp pattern_ops[] = {
+        LedPatternOp::set(100, 250), LedPatternOp::set(0, 250), LedPatternOp::loop(2, 0), LedPatternOp::hold(1000), LedPatternOp::jump(0)
+    };
+    static constexpr LedPattern pattern(pattern_ops, 5);
+    t = wall_ns();
+    for(int i=0;i<CALL_ITERATIONS;i++){
+        led.play(&pattern);
+    }
+    report("api", "play_ns_per_call", (double)(wall_ns() - t) / CALL_ITERATIONS, 1);
+    led.cancelBlinkMode();
+
+    LedT<LedPwmOutput> led_t(PIN_BENCH + 1, 1, NULL, &sched);
+    t = wall_ns();
+    for(int i=0;i<CALL_ITERATIONS;i++){
+        led_t.on(0, (uint8_t)(i & 63));
+    }
+    report("api", "LedT_on_ns_per_call", (double)(wall_ns() - t) / CALL_ITERATIONS, 1);
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_callbacks(const char* name, int mode){
+    const uint32_t blink_sequence[] = {50, 50, 50, 250};
+    LedScheduler sched;
+    Led* leds[CALLBACK_LEDS];
+    for(int i=0;i<CALLBACK_LEDS;i++){
+        leds[i] = new Led(PIN_BENCH + i, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+        switch(mode){
+            case 0: leds[i]->blink(10 + (i % 7), 10 + (i % 5)); break;
+            case 1: leds[i]->setBlinkMode(blink_sequence, 4); break;
+            default: break;
+        }
+    }
+    uint32_t callbacks = 0;
+    uint64_t ns = 0;
+    for(int s=0;s<CALLBACK_SECONDS;s++){
+        if(mode == 2){
+            // rampas continuas de 1s de subida y bajada
+            for(int i=0;i<CALLBACK_LEDS;i++){
+                if(s & 1){ leds[i]->off(0, 0, 1000); } else { leds[i]->on(0, 100, 1000); }
+            }
+        }
+        VirtualClock::clearWrites();
+        uint64_t t = wall_ns();
+        VirtualClock::advance(1000000);
+        ns += wall_ns() - t;
+        callbacks += VirtualClock::getWriteCount();
+    }
+    // cada escritura corresponde a un callback de led (blinkCb, rampCb o patternCb)
+    report(name, "ns_per_callback", (double)ns / callbacks, CALLBACK_LEDS);
+    report(name, "callbacks_per_sec", (callbacks * 1.0e9) / ns, CALLBACK_LEDS);
+    for(int i=0;i<CALLBACK_LEDS;i++){
+        delete(leds[i]);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_writes_per_change(){
+    const uint32_t blink_sequence[] = {250, 250, 250, 1000};
+    LedScheduler sched;
+    Led led(PIN_BENCH, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+
+    VirtualClock::clearWrites();
+    led.on();
+    report("writes", "on", VirtualClock::getWriteCount(), 1);
+
+    VirtualClock::clearWrites();
+    led.off();
+    report("writes", "off", VirtualClock::getWriteCount(), 1);
+
+    VirtualClock::clearWrites();
+    led.on(0, 100, 1000);
+    VirtualClock::advance(1100000);
+    report("writes", "on_ramp_1s", VirtualClock::getWriteCount(), 1);
+
+    led.off();
+    VirtualClock::clearWrites();
+    led.on(200);
+    VirtualClock::advance(250000);
+    report("writes", "on_temporal", VirtualClock::getWriteCount(), 1);
+
+    VirtualClock::clearWrites();
+    led.blink(250, 250);
+    VirtualClock::advance(499999);
+    report("writes", "blink_cycle", VirtualClock::getWriteCount(), 1);
+
+    VirtualClock::clearWrites();
+    led.setBlinkMode(blink_sequence, 4);
+    VirtualClock::advance(1749999);
+    report("writes", "blink_mode_cycle", VirtualClock::getWriteCount(), 1);
+    led.cancelBlinkMode();
+
+    // registro sombra: escrituras realizadas frente a evitadas en toda la secuencia
+    report("writes", "issued_total", led.getWritesIssued(), 1);
+    report("writes", "suppressed_total", led.getWritesSuppressed(), 1);
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_memory(){
+    static const int counts[] = {1, 10, 100, 1000, 10000};
+    report("memory", "sizeof_Led", sizeof(Led), 1);
+    report("memory", "sizeof_LedT_pwm", sizeof(LedT<LedPwmOutput>), 1);
+    report("memory", "sizeof_LedT_digital", sizeof(LedT<LedDigitalOutput>), 1);
+    for(size_t c=0;c<sizeof(counts)/sizeof(counts[0]);c++){
+        int n = counts[c];
+        // montículo con almacenamiento externo (como LedSchedulerT): el planificador no reserva memoria dinámica
+        LedScheduler::Event** heap_storage = new LedScheduler::Event*[1 + (n * Led::EventsPerLed)];
+        LedScheduler sched(heap_storage, 1 + (n * Led::EventsPerLed));
+        // los contadores por pin de la HAL se reservan fuera de la medida
+        DigitalOut(PIN_BENCH + n).write(0);
+        size_t heap0 = s_heap_bytes;
+        size_t allocs0 = s_heap_allocs;
+        // el array de objetos Led se reserva aparte para medir sólo la memoria propia de cada led
+        char* storage = (char*)malloc(sizeof(Led) * n);
+        for(int i=0;i<n;i++){
+            new(storage + (i * sizeof(Led))) Led(PIN_BENCH + i, (i & 1)? Led::LedDimmableType : Led::LedOnOffType, Led::OnIsHighLevel, 1, NULL, &sched);
+        }
+        size_t heap = s_heap_bytes - heap0;
+        size_t allocs = s_heap_allocs - allocs0;
+        report("memory", "bytes_per_led", sizeof(Led) + ((double)heap / n), n);
+        report("memory", "heap_allocs_per_led", (double)allocs / n, n);
+        for(int i=0;i<n;i++){
+            ((Led*)(storage + (i * sizeof(Led))))->~Led();
+        }
+        free(storage);
+        delete[](heap_storage);
+    }
+}
+
+
+
+//------------------------------------------------------------------------------------
+static void bench_command_queue(int threads){
+    LedSchedulerT<64> sched;
+    static LedCommandQueueT<256> queue;
+    sched.attachQueue(&queue);
+    Led* leds[QUEUE_LEDS];
+    for(int i=0;i<QUEUE_LEDS;i++){
+        leds[i] = new Led(PIN_BENCH + i, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+    }
+    // ráfagas que caben en la cola: se mide la inserción de comandos aceptados, no el descarte por cola llena
+    const int burst = queue.capacity() / threads;
+    const int rounds = QUEUE_POSTS / burst;
+    uint32_t dropped0 = queue.getDropped();
+    std::atomic<int> ready(0);
+    std::atomic<int> posted(0);
+    std::atomic<int> round(0);
+    std::vector<uint64_t> ns(threads, 0);
+    std::vector<std::vector<uint32_t> > lat(threads);
+
+    // consumidor: al completar cada ráfaga avanza el reloj virtual y el planificador vacía la cola
+    uint64_t t_start = wall_ns();
+    std::thread isr([&](){
+        for(int r=0;r<rounds;r++){
+            while(posted.load() < (threads * (r + 1))){
+                std::this_thread::yield();
+            }
+            VirtualClock::advance(10);
+            round++;
+        }
+    });
+    std::vector<std::thread> producers;
+    for(int p=0;p<threads;p++){
+        producers.push_back(std::thread([&, p](){
+            Led* led = leds[p % QUEUE_LEDS];
+            lat[p].reserve(burst * rounds);
+            ready++;
+            while(ready.load() < threads){}
+            for(int r=0;r<rounds;r++){
+                uint64_t t0 = wall_ns();
+                for(int i=0;i<burst;i++){
+                    uint64_t t = wall_ns();
+                    led->on(0, (uint8_t)(i & 63));
+                    lat[p].push_back((uint32_t)(wall_ns() - t));
+                }
+                ns[p] += wall_ns() - t0;
+                posted++;
+                while(round.load() <= r){
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for(size_t p=0;p<producers.size();p++){
+        producers[p].join();
+    }
+    isr.join();
+    uint64_t ns_total = wall_ns() - t_start;
+
+    double ns_avg = 0;
+    std::vector<uint32_t> all;
+    for(int p=0;p<threads;p++){
+        ns_avg += (double)ns[p] / (burst * rounds);
+        all.insert(all.end(), lat[p].begin(), lat[p].end());
+    }
+    ns_avg /= threads;
+    std::sort(all.begin(), all.end());
+    uint64_t posts = (uint64_t)burst * rounds * threads;
+    report("queue", "post_ns_per_call", ns_avg, threads);
+    report("queue", "post_ns_p50", all[all.size() / 2], threads);
+    report("queue", "post_ns_p99", all[(all.size() * 99) / 100], threads);
+    report("queue", "posts_per_sec", (posts * 1.0e9) / *std::max_element(ns.begin(), ns.end()), threads);
+    // inserción y aplicación en el contexto del planificador
+    report("queue", "applied_per_sec", (posts * 1.0e9) / ns_total, threads);
+    report("queue", "dropped_ratio", (double)(queue.getDropped() - dropped0) / posts, threads);
+    for(int i=0;i<QUEUE_LEDS;i++){
+        delete(leds[i]);
+    }
+    sched.attachQueue(NULL);
+}
+
+
+
+//------------------------------------------------------------------------------------
+template<uint16_t N>
+static void bench_bank(){
+    // mismo trabajo en ambos casos: leds pares en rampa continua de 1s, impares parpadeando a 10/15ms
+    static LedBankT<N> bank(1000);
+    uint32_t t = 0;
+    for(uint16_t i=0;i<N;i++){
+        if(i & 1){ bank.blink(i, 10, 15); } else { bank.on(i, 0, 100, 1000); }
+    }
+    uint64_t changes = 0;
+    uint64_t ns = 0;
+    for(int s=0;s<BANK_SECONDS;s++){
+        uint64_t t0 = wall_ns();
+        for(int f=0;f<1000;f++){
+            t += 1000;
+            changes += bank.update(t);
+        }
+        ns += wall_ns() - t0;
+        for(uint16_t i=0;i<N;i+=2){
+            if(s & 1){ bank.on(i, 0, 100, 1000); } else { bank.off(i, 0, 0, 1000); }
+        }
+    }
+    // mismas métricas en ambos casos: cambios de salida por segundo y tiempo real por segundo simulado
+    report("bank", "LedBank_changes_per_sec", (changes * 1.0e9) / ns, N);
+    report("bank", "LedBank_ns_per_sim_sec", (double)ns / BANK_SECONDS, N);
+
+    LedScheduler sched(N + 16);
+    Led* leds = (Led*)malloc(sizeof(Led) * N);
+    for(uint16_t i=0;i<N;i++){
+        new(&leds[i]) Led(PIN_BENCH + i, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+        if(i & 1){ leds[i].blink(10, 15); } else { leds[i].on(0, 100, 1000); }
+    }
+    ns = 0;
+    changes = 0;
+    for(int s=0;s<BANK_SECONDS;s++){
+        VirtualClock::clearWrites();
+        uint64_t t0 = wall_ns();
+        VirtualClock::advance(1000000);
+        ns += wall_ns() - t0;
+        changes += VirtualClock::getWriteCount();
+        for(uint16_t i=0;i<N;i+=2){
+            if(s & 1){ leds[i].on(0, 100, 1000); } else { leds[i].off(0, 0, 1000); }
+        }
+    }
+    // cada escritura de un objeto Led es un cambio de su salida
+    report("bank", "Led_changes_per_sec", (changes * 1.0e9) / ns, N);
+    report("bank", "Led_ns_per_sim_sec", (double)ns / BANK_SECONDS, N);
+    for(uint16_t i=0;i<N;i++){
+        leds[i].~Led();
+    }
+    free(leds);
+}
+
+
+
+//------------------------------------------------------------------------------------
+static void bench_bam(int channels){
+    // carga de cpu por led: canales a niveles distintos, la mitad en rampa continua de 1s
+    LedScheduler sched(64);
+    uint32_t mask = (channels >= 32)? 0xFFFFFFFFUL : ((1UL << channels) - 1);
+    LedBam bam((PortName)PORT_BENCH, mask, 8, 8, &sched);
+    Led* leds = (Led*)malloc(sizeof(Led) * channels);
+    for(int i=0;i<channels;i++){
+        new(&leds[i]) Led(&bam, (uint8_t)i, Led::OnIsHighLevel, NULL, &sched);
+        if(i & 1){ leds[i].on(0, 100, 1000); } else { leds[i].on(0, (uint8_t)(10 + (i * 3)), 0); }
+    }
+    uint64_t ns = 0;
+    uint32_t writes = bam.getPortWrites();
+    for(int s=0;s<BAM_SECONDS;s++){
+        VirtualClock::clearWrites();
+        uint64_t t0 = wall_ns();
+        VirtualClock::advance(1000000);
+        ns += wall_ns() - t0;
+        for(int i=1;i<channels;i+=2){
+            if(s & 1){ leds[i].on(0, 100, 1000); } else { leds[i].off(0, 0, 1000); }
+        }
+    }
+    writes = bam.getPortWrites() - writes;
+    report("bam", "ns_per_led_per_sec", (double)ns / (BAM_SECONDS * channels), channels);
+    report("bam", "port_writes_per_sec", (double)writes / BAM_SECONDS, channels);
+    for(int i=0;i<channels;i++){
+        leds[i].~Led();
+    }
+    free(leds);
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_trace(){
+    // coste de un registro con el registro activo y desactivado en ejecución
+    LedTrace::clear();
+    for(int enabled=0;enabled<2;enabled++){
+        LedTrace::enable(enabled != 0);
+        uint64_t t0 = wall_ns();
+        for(uint32_t i=0;i<CALL_ITERATIONS;i++){
+            LedTrace::record(LedTrace::EvWrite, PIN_BENCH, (uint16_t)i);
+        }
+        report("trace", enabled? "ns_per_record" : "ns_per_record_disabled", (double)(wall_ns() - t0) / CALL_ITERATIONS, 1);
+    }
+    LedTrace::enable(false);
+    report("trace", "sizeof_record", sizeof(LedTraceRecord), 1);
+    report("trace", "dump_max_size", LedTrace::DumpMaxSize, 1);
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_stats(){
+    // coste de una instantánea sin bloqueos (lectura desde la tarea de monitorización)
+    LedScheduler sched;
+    LedStats storage;
+    Led led(PIN_BENCH, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+    led.attachStats(&storage);
+    LedStats stats;
+    LedSchedulerStats sched_stats;
+    int errors = 0;
+    uint64_t t0 = wall_ns();
+    for(uint32_t i=0;i<CALL_ITERATIONS;i++){
+        errors += (led.getStats(stats) != 0)? 1 : 0;
+    }
+    report("stats", "ns_per_led_snapshot", (double)(wall_ns() - t0) / CALL_ITERATIONS, 1);
+    t0 = wall_ns();
+    for(uint32_t i=0;i<CALL_ITERATIONS;i++){
+        errors += (sched.getStats(sched_stats) != 0)? 1 : 0;
+    }
+    report("stats", "ns_per_sched_snapshot", (double)(wall_ns() - t0) / CALL_ITERATIONS, 1);
+    report("stats", "snapshot_errors", errors, 1);
+    report("stats", "sizeof_LedStats", sizeof(LedStats), 1);
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_waveform(){
+    // intervenciones de cpu de una rampa de 1s: callbacks del timer frente a adopciones del buffer precalculado
+    LedScheduler sched;
+    LedStats storage;
+    Led led(PIN_BENCH, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+    led.attachStats(&storage);
+    LedStats stats;
+    stats.clear();
+    led.on(0, 100, 1000);
+    VirtualClock::advance(1000000);
+    led.getStats(stats);
+    report("waveform", "led_ramp_1s_callbacks", stats.callbacks[LedStats::CbRamp], 1);
+    static MockWaveSink sink;
+    static LedWaveformT<2048> wave(&sink, 1000);
+    uint64_t t0 = wall_ns();
+    wave.renderRamp(0xFFFF, 1000);
+    report("waveform", "render_ramp_1s_ns", (double)(wall_ns() - t0), 1);
+    sink.run(1001);
+    report("waveform", "sink_ramp_1s_interrupts", sink.getAdoptions(), 1);
+    // orden repetida: sin recálculo
+    t0 = wall_ns();
+    for(uint32_t i=0;i<CALL_ITERATIONS;i++){
+        wave.renderRamp(0xFFFF, 1000);
+    }
+    report("waveform", "render_unchanged_ns_per_call", (double)(wall_ns() - t0) / CALL_ITERATIONS, 1);
+    report("waveform", "sizeof_LedWaveformT_2048", sizeof(wave), 1);
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_slack(uint32_t slack_us){
+    // despertares por minuto de una mezcla realista de patrones arrancados en instantes distintos
+    const uint32_t double_blink[] = {150, 150, 150, 1550};
+    const uint32_t sos[] = {100, 100, 100, 100, 100, 300, 300, 100, 300, 100, 300, 300, 100, 100, 100, 2000};
+    LedScheduler sched;
+    Led* leds[SLACK_LEDS];
+    uint32_t seed = 12345;
+    for(int i=0;i<SLACK_LEDS;i++){
+        leds[i] = new Led(PIN_BENCH + i, Led::LedOnOffType, Led::OnIsHighLevel, 1, NULL, &sched);
+        leds[i]->setSlack(slack_us);
+        switch(i % 4){
+            case 0: leds[i]->blink(100, 900); break;                        // latido
+            case 1: leds[i]->blink(500, 500); break;                        // estado
+            case 2: leds[i]->setBlinkMode(double_blink, 4); break;          // notificación
+            default: leds[i]->setBlinkMode(sos, 16); break;                 // alarma
+        }
+        seed = (seed * 1103515245UL) + 12345UL;
+        VirtualClock::advance(1000 + ((seed >> 8) % 50000));
+    }
+    LedSchedulerStats st0, st1;
+    st0.clear();
+    st1.clear();
+    sched.getStats(st0);
+    for(int s=0;s<SLACK_SECONDS;s++){
+        VirtualClock::clearWrites();
+        VirtualClock::advance(1000000);
+    }
+    sched.getStats(st1);
+    char metric[48];
+    sprintf(metric, "wakeups_per_min_slack_%uus", (unsigned)slack_us);
+    report("slack", metric, (double)(st1.passes - st0.passes) * 60 / SLACK_SECONDS, SLACK_LEDS);
+    sprintf(metric, "lateness_max_slack_%uus", (unsigned)slack_us);
+    report("slack", metric, st1.lateness.max, SLACK_LEDS);
+    for(int i=0;i<SLACK_LEDS;i++){
+        delete(leds[i]);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_state(){
+    // instantánea del estado de muchos leds: lectura individual frente a una única copia de la tabla
+    LedScheduler sched(2 * STATE_LEDS);
+    static LedStateTableT<STATE_LEDS> table;
+    std::vector<Led*> leds;
+    for(int i=0;i<STATE_LEDS;i++){
+        Led* led = new Led(PIN_BENCH + i, Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+        led->blink(50 + (i % 7), 50);
+        table.attach(led);
+        leds.push_back(led);
+    }
+    static LedState snap[STATE_LEDS];
+    int errors = 0;
+    uint64_t t0 = wall_ns();
+    for(uint32_t n=0;n<STATE_SNAPSHOTS;n++){
+        for(int i=0;i<STATE_LEDS;i++){
+            errors += (leds[i]->getState(snap[i]) != 0)? 1 : 0;
+        }
+    }
+    report("state", "ns_per_snapshot_getState", (double)(wall_ns() - t0) / STATE_SNAPSHOTS, STATE_LEDS);
+    t0 = wall_ns();
+    for(uint32_t n=0;n<STATE_SNAPSHOTS;n++){
+        errors += (table.snapshot(snap, STATE_LEDS) != STATE_LEDS)? 1 : 0;
+    }
+    report("state", "ns_per_snapshot_table", (double)(wall_ns() - t0) / STATE_SNAPSHOTS, STATE_LEDS);
+    report("state", "snapshot_errors", errors, STATE_LEDS);
+    report("state", "sizeof_LedState", sizeof(LedState), 1);
+    for(int i=0;i<STATE_LEDS;i++){
+        delete(leds[i]);
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_duty(const LedGammaTable* gamma){
+    // ancho de pulso de todos los niveles Q16: cuentas enteras frente al ciclo de trabajo en coma flotante
+    // de PwmOut::write (LED_DOUBLE_OUTPUT_SHIM), con el error respecto al redondeo exacto
+    const uint32_t period_us = 1000;
+    const int reps = 16;
+    volatile uint32_t sink = 0;
+    uint64_t t0 = wall_ns();
+    for(int r=0;r<reps;r++){
+        for(uint32_t v=0;v<=0xFFFF;v++){
+            sink = sink + LedPwmOutput::pulse<LedActiveHigh>((uint16_t)v, gamma, period_us);
+        }
+    }
+    report("duty", (gamma == NULL)? "int_ns_per_level" : "int_gamma_ns_per_level", (double)(wall_ns() - t0) / (reps * 0x10000), 1);
+    t0 = wall_ns();
+    for(int r=0;r<reps;r++){
+        for(uint32_t v=0;v<=0xFFFF;v++){
+            uint8_t bits;
+            uint32_t duty = LedPwmOutput::duty<LedActiveHigh>((uint16_t)v, gamma, bits);
+            float value = (float)duty / ((1UL << bits) - 1);
+            sink = sink + (uint32_t)(value * period_us);
+        }
+    }
+    report("duty", (gamma == NULL)? "float_ns_per_level" : "float_gamma_ns_per_level", (double)(wall_ns() - t0) / (reps * 0x10000), 1);
+    uint32_t err_int = 0, err_float = 0;
+    for(uint32_t v=0;v<=0xFFFF;v++){
+        uint8_t bits;
+        uint32_t duty = LedPwmOutput::duty<LedActiveHigh>((uint16_t)v, gamma, bits);
+        uint32_t full_scale = (1UL << bits) - 1;
+        uint32_t exact = (uint32_t)((((uint64_t)period_us * duty * 2) + full_scale) / (2 * full_scale));
+        uint32_t pi = LedPwmOutput::pulse<LedActiveHigh>((uint16_t)v, gamma, period_us);
+        uint32_t pf = (uint32_t)(((float)duty / full_scale) * period_us);
+        err_int = std::max(err_int, (pi > exact)? (pi - exact) : (exact - pi));
+        err_float = std::max(err_float, (pf > exact)? (pf - exact) : (exact - pf));
+    }
+    report("duty", (gamma == NULL)? "int_max_error_us" : "int_gamma_max_error_us", err_int, 1);
+    report("duty", (gamma == NULL)? "float_max_error_us" : "float_gamma_max_error_us", err_float, 1);
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_dummy_cb(){
+}
+
+
+//------------------------------------------------------------------------------------
+static void bench_sched(int count){
+    // planificación de count eventos: un Ticker por evento frente al planificador compartido
+    std::vector<Ticker> tickers(count);
+    std::vector<LedScheduler::Event> events(count);
+    LedScheduler sched(count);
+    uint64_t t0 = wall_ns();
+    for(int i=0;i<count;i++){
+        tickers[i].attach_us(callback(bench_dummy_cb), 1000000 + (i * 1000));
+    }
+    uint32_t ticker_timers = VirtualClock::getActiveTickers();
+    for(int i=0;i<count;i++){
+        tickers[i].detach();
+    }
+    report("sched", "ticker_attach_detach_ns_per_event", (double)(wall_ns() - t0) / count, count);
+    report("sched", "ticker_timers_armed", ticker_timers, count);
+    int errors = 0;
+    t0 = wall_ns();
+    for(int i=0;i<count;i++){
+        errors += (sched.schedule(&events[i], callback(bench_dummy_cb), 1000000 + (i * 1000)) != 0)? 1 : 0;
+    }
+    uint32_t sched_timers = VirtualClock::getActiveTickers();
+    for(int i=0;i<count;i++){
+        sched.cancel(&events[i]);
+    }
+    report("sched", "sched_schedule_cancel_ns_per_event", (double)(wall_ns() - t0) / count, count);
+    report("sched", "sched_timers_armed", sched_timers, count);
+    report("sched", "schedule_errors", errors, count);
+}
+
+
+//------------------------------------------------------------------------------------
+//-- BENCH ENRY POINT ----------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+int main(){
+    VirtualClock::reset();
+    VirtualClock::setRecording(false);
+    bench_api_calls();
+    bench_callbacks("blinkCb", 0);
+    bench_callbacks("patternCb", 1);
+    bench_callbacks("rampCb", 2);
+    bench_writes_per_change();
+    bench_memory();
+    bench_command_queue(1);
+    bench_command_queue(2);
+    bench_command_queue(4);
+    bench_bank<100>();
+    bench_bank<1000>();
+    bench_bank<10000>();
+    bench_bam(1);
+    bench_bam(8);
+    bench_bam(32);
+    bench_trace();
+    bench_stats();
+    bench_waveform();
+    bench_slack(0);
+    bench_slack(5000);
+    bench_slack(20000);
+    bench_slack(50000);
+    bench_state();
+    bench_duty(NULL);
+    bench_duty(&LedGamma<LedCurveCie1931>::table);
+    bench_sched(16);
+    bench_sched(256);
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * mbed.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Sustituto de la API mbed para compilar y ejecutar el driver en un host Linux. Las clases Timer, Ticker,
+ *  PwmOut y DigitalOut funcionan sobre un reloj virtual determinista (VirtualClock) que los tests avanzan
+ *  manualmente. Todas las escrituras en las salidas quedan registradas con su marca de tiempo.
+ *
+ */
+
+#ifndef __mbed_host__H
+#define __mbed_host__H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "VirtualClock.h"
+
+
+/** Identificadores de pin y de puerto */
+typedef int PinName;
+typedef int PinName32;
+typedef int PortName;
+#define NC  ((PinName)-1)
+
+
+//------------------------------------------------------------------------------------
+//-- Callback ------------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+template<typename F> class Callback;
+
+/** Callback<void()> con la misma estructura que la de mbed: función libre o par objeto/método sin reserva de memoria */
+template<> class Callback<void()>{
+  public:
+    Callback() : _obj(NULL), _thunk(NULL) { memset(_buf, 0, sizeof(_buf)); }
+
+    Callback(void (*fn)()) : _obj(NULL), _thunk((fn != NULL)? &fnThunk : NULL) {
+        memset(_buf, 0, sizeof(_buf));
+        memcpy(_buf, &fn, sizeof(fn));
+    }
+
+    template<typename T> Callback(T* obj, void (T::*method)()) : _obj(obj), _thunk(&methodThunk<T>) {
+        static_assert(sizeof(method) <= sizeof(_buf), "Callback: puntero a método demasiado grande");
+        memset(_buf, 0, sizeof(_buf));
+        memcpy(_buf, &method, sizeof(method));
+    }
+
+    void call() const { if(_thunk != NULL){ _thunk(this); } }
+    void operator()() const { call(); }
+    operator bool() const { return (_thunk != NULL); }
+
+  private:
+    struct Dummy {};
+    union{
+        char _buf[sizeof(void (Dummy::*)())];
+        void* _align;
+    };
+    void* _obj;
+    void (*_thunk)(const Callback*);
+
+    static void fnThunk(const Callback* cb){
+        void (*fn)();
+        memcpy(&fn, cb->_buf, sizeof(fn));
+        fn();
+    }
+
+    template<typename T> static void methodThunk(const Callback* cb){
+        void (T::*method)();
+        memcpy(&method, cb->_buf, sizeof(method));
+        (static_cast<T*>(cb->_obj)->*method)();
+    }
+};
+
+template<typename T> Callback<void()> callback(T* obj, void (T::*method)()) { return Callback<void()>(obj, method); }
+inline Callback<void()> callback(void (*fn)()) { return Callback<void()>(fn); }
+
+
+//------------------------------------------------------------------------------------
+//-- Secciones críticas --------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+void core_util_critical_section_enter();
+void core_util_critical_section_exit();
+
+
+//------------------------------------------------------------------------------------
+//-- Operaciones atómicas ------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+inline uint32_t core_util_atomic_load_u32(const volatile uint32_t* ptr){
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+inline void core_util_atomic_store_u32(volatile uint32_t* ptr, uint32_t value){
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+inline bool core_util_atomic_cas_u32(volatile uint32_t* ptr, uint32_t* expected, uint32_t desired){
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+inline uint32_t core_util_atomic_incr_u32(volatile uint32_t* ptr, uint32_t delta){
+    return __atomic_add_fetch(ptr, delta, __ATOMIC_SEQ_CST);
+}
+
+
+//------------------------------------------------------------------------------------
+//-- Timer / Ticker ------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+class Timer{
+  public:
+    Timer() : _t0(0), _acc(0), _running(false) {}
+    void start(){ if(!_running){ _t0 = VirtualClock::now(); _running = true; } }
+    void stop(){ if(_running){ _acc += VirtualClock::now() - _t0; _running = false; } }
+    void reset(){ _acc = 0; _t0 = VirtualClock::now(); }
+    uint64_t read_high_resolution_us(){ return _acc + (_running? (VirtualClock::now() - _t0) : 0); }
+    int read_us(){ return (int)read_high_resolution_us(); }
+    int read_ms(){ return (int)(read_high_resolution_us() / 1000); }
+  private:
+    uint64_t _t0;
+    uint64_t _acc;
+    bool _running;
+};
+
+
+/** Ticker de microsegundos de la HAL */
+inline uint32_t us_ticker_read(){ return (uint32_t)VirtualClock::now(); }
+
+
+class Ticker{
+  public:
+    Ticker() {}
+    ~Ticker(){ detach(); }
+    void attach_us(Callback<void()> cb, uint32_t us){ VirtualClock::attach(this, cb, us); }
+    void detach(){ VirtualClock::detach(this); }
+  private:
+    Ticker(const Ticker&);
+    Ticker& operator=(const Ticker&);
+};
+
+
+//------------------------------------------------------------------------------------
+//-- Salidas -------------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+class DigitalOut{
+  public:
+    DigitalOut(PinName pin, int value = 0) : _pin(pin), _value(value) {}
+    void write(int value){ _value = (value != 0)? 1 : 0; VirtualClock::logWrite(_pin, VirtualClock::DigitalWrite, _value, 0); }
+    int read(){ return _value; }
+    DigitalOut& operator=(int value){ write(value); return *this; }
+    operator int(){ return read(); }
+  private:
+    PinName _pin;
+    int _value;
+};
+
+
+class PwmOut{
+  public:
+    PwmOut(PinName pin) : _pin(pin), _period_us(20000), _pulse_us(0) {}
+    void period_ms(int ms){ period_us(ms * 1000); }
+    void period_us(int us){ _period_us = us; _pulse_us = (_pulse_us > _period_us)? _period_us : _pulse_us; }
+    void period(float seconds){ period_us((int)(seconds * 1000000.0f)); }
+    void pulsewidth_us(int us){ _pulse_us = us; VirtualClock::logWrite(_pin, VirtualClock::PwmWrite, _pulse_us, _period_us); }
+    void pulsewidth_ms(int ms){ pulsewidth_us(ms * 1000); }
+    void write(float value){ pulsewidth_us((int)((value * _period_us) + 0.5f)); }
+    float read(){ return (_period_us > 0)? ((float)_pulse_us / _period_us) : 0; }
+  private:
+    PinName _pin;
+    int _period_us;
+    int _pulse_us;
+};
+
+
+class PortOut{
+  public:
+    PortOut(PortName port, int mask = 0xFFFFFFFF) : _port(port), _mask(mask), _value(0) {}
+    void write(int value){ _value = value & _mask; VirtualClock::logWrite(_port, VirtualClock::PortWrite, _value, 0); }
+    int read(){ return _value; }
+    PortOut& operator=(int value){ write(value); return *this; }
+    operator int(){ return read(); }
+  private:
+    PortName _port;
+    int _mask;
+    int _value;
+};
+
+
+#endif /*__mbed_host__H */
+
+/**** END OF FILE ****/
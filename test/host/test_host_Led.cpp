@@ -0,0 +1,1652 @@
+/*
+ * test_host_Led.cpp
+ *
+ *	Test unitario del módulo Driver_Led sobre la HAL de host (reloj virtual)
+ */
+
+
+
+//------------------------------------------------------------------------------------
+//-- TEST HEADERS --------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+#include "mbed.h"
+#include "unity.h"
+#include "Led.h"
+#include "LedStorage.h"
+#include "LedGroup.h"
+#include "LedBank.h"
+#include "LedBam.h"
+#include "ColorLed.h"
+#include "LedWaveform.h"
+#include "MockWaveSink.h"
+
+
+//------------------------------------------------------------------------------------
+//-- SPECIFIC COMPONENTS FOR TESTING -------------------------------------------------
+//------------------------------------------------------------------------------------
+
+#define PIN_LED_A				1
+#define PIN_LED_B				2
+#define PIN_LED_BANK			100
+#define PWM_PERIOD_MS			1
+#define PWM_PERIOD_US			(PWM_PERIOD_MS * 1000)
+#define BANK_COUNT				50
+#define PIN_LED_C				3
+#define DRIFT_LATENCY_US		20
+#define DRIFT_HOURS				24
+#define PORT_BAM				200
+#define BAM_LSB_US				8
+
+
+/** Tabla de configuración en flash y almacenamiento estático */
+static constexpr LedConfig led_cfg[] = {
+	LedConfig(PIN_LED_A, Led::LedOnOffType),
+	LedConfig(PIN_LED_B, Led::LedDimmableType, Led::OnIsLowLevel, PWM_PERIOD_MS),
+};
+static LedStorage<2> led_storage;
+
+
+/** Parpadeo de referencia con la implementación anterior: el Ticker se rearma relativo al instante actual */
+class RelativeBlinker{
+  public:
+    RelativeBlinker(PinName pin, uint32_t half_period_us) : _out(pin), _us(half_period_us), _level(1) {
+        _out.write(_level);
+        _tick.attach_us(callback(this, &RelativeBlinker::blinkCb), _us);
+    }
+  private:
+    DigitalOut _out;
+    Ticker _tick;
+    uint32_t _us;
+    int _level;
+    void blinkCb(){
+        _level ^= 1;
+        _out.write(_level);
+        _tick.detach();
+        _tick.attach_us(callback(this, &RelativeBlinker::blinkCb), _us);
+    }
+};
+
+
+//------------------------------------------------------------------------------------
+//-- TEST FUNCTIONS ------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+static int last_value(int pin){
+	const VirtualClock::Write* w = VirtualClock::getLastWrite(pin);
+	TEST_ASSERT_NOT_NULL(w);
+	return (w != NULL)? w->value : -1;
+}
+
+
+//------------------------------------------------------------------------------------
+static uint64_t last_time(int pin){
+	const VirtualClock::Write* w = VirtualClock::getLastWrite(pin);
+	TEST_ASSERT_NOT_NULL(w);
+	return (w != NULL)? w->t_us : 0;
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_default_off(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	led.on();
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	led.on(0, 50);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US / 2, last_value(PIN_LED_A));
+	led.off();
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// periodos largos: el ancho de pulso no desborda
+	Led slow(PIN_LED_B, Led::LedDimmableType, Led::OnIsHighLevel, 100, NULL, &sched);
+	slow.on(0, 100);
+	TEST_ASSERT_EQUAL(100000, last_value(PIN_LED_B));
+	slow.on(0, 50);
+	TEST_ASSERT_INT_WITHIN(1, 50001, last_value(PIN_LED_B));
+	TEST_ASSERT_EQUAL(0, slow.setPeriodUs(1000000));
+	// error inferior a un paso de 16 bits del ciclo de trabajo (periodo / 65536)
+	TEST_ASSERT_INT_WITHIN(16, 500008, last_value(PIN_LED_B));
+	slow.setDithering(true);
+	slow.on(0, 100);
+	TEST_ASSERT_EQUAL(1000000, last_value(PIN_LED_B));
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_low_level_gamma(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsLowLevel, PWM_PERIOD_MS, &LedGamma<LedCurveCie1931>::table, &sched);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	led.on();
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// CIE 1931: el 50% de luminosidad percibida corresponde a un ~18% de ciclo de trabajo
+	led.on(0, 50);
+	TEST_ASSERT_INT_WITHIN(10, PWM_PERIOD_US - 186, last_value(PIN_LED_A));
+	Led digital(PIN_LED_B, Led::LedOnOffType, Led::OnIsLowLevel, 0, NULL, &sched);
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_B));
+	digital.on();
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_B));
+	// intensidades de 16 bits con gamma: interpoladas entre entradas de la tabla, no truncadas a 8 bits
+	Led fine(PIN_LED_C, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, &LedGamma<LedCurveCie1931>::table, &sched);
+	TEST_ASSERT_EQUAL(0, fine.setPeriodUs(1000000));
+	int prev = 0;
+	for(uint16_t v=0x0040;v<=0x0200;v+=0x0040){
+		fine.on(0, LedLevel(v));
+		TEST_ASSERT_TRUE(last_value(PIN_LED_C) > prev);
+		prev = last_value(PIN_LED_C);
+	}
+	fine.on(0, LedLevel(0xFFFF));
+	TEST_ASSERT_EQUAL(1000000, last_value(PIN_LED_C));
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_blink(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	VirtualClock::clearWrites();
+	uint64_t t0 = VirtualClock::now();
+	led.blink(250, 250);
+	VirtualClock::advance(1000000);
+	const std::vector<VirtualClock::Write>& w = VirtualClock::getWrites();
+	TEST_ASSERT_EQUAL(5, w.size());
+	for(size_t i=0;i<w.size();i++){
+		TEST_ASSERT_EQUAL(t0 + (i * 250000), w[i].t_us);
+		TEST_ASSERT_EQUAL((i & 1)? 0 : 1, w[i].value);
+	}
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_ramp_end_time(){
+	static const uint32_t durations[] = {1, 7, 100, 999, 1000, 2550, 3001};
+	static const LedEasing curves[] = {LedEasingLinear, LedEasingIn, LedEasingOut, LedEasingInOut, LedEasingExp, LedEasingSCurve};
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	for(size_t c=0;c<sizeof(curves)/sizeof(curves[0]);c++){
+		led.setRampCurve(curves[c]);
+		for(size_t d=0;d<sizeof(durations)/sizeof(durations[0]);d++){
+			// rampa de subida: el último paso vence exactamente en t0 + duración. Las curvas con tramos planos
+			// pueden alcanzar el destino antes: esos pasos no escriben la salida
+			VirtualClock::clearWrites();
+			uint64_t t0 = VirtualClock::now();
+			led.on(0, 100, durations[d]);
+			VirtualClock::advance((durations[d] * 1000) - 1);
+			TEST_ASSERT_EQUAL(1, sched.pending());
+			VirtualClock::advance(1);
+			TEST_ASSERT_EQUAL(0, sched.pending());
+			VirtualClock::advance(5000);
+			TEST_ASSERT_TRUE(last_time(PIN_LED_A) <= t0 + (durations[d] * 1000));
+			TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+			TEST_ASSERT_TRUE(VirtualClock::getWriteCount(PIN_LED_A) <= LedRamp::MaxSteps);
+
+			// rampa de bajada
+			t0 = VirtualClock::now();
+			led.off(0, 0, durations[d]);
+			VirtualClock::advance((durations[d] * 1000) - 1);
+			TEST_ASSERT_EQUAL(1, sched.pending());
+			VirtualClock::advance(1);
+			TEST_ASSERT_EQUAL(0, sched.pending());
+			VirtualClock::advance(5000);
+			TEST_ASSERT_TRUE(last_time(PIN_LED_A) <= t0 + (durations[d] * 1000));
+			TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+		}
+	}
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_ramp_monotonic(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	led.setRampCurve(LedEasingSCurve);
+	VirtualClock::clearWrites();
+	led.on(0, 100, 500);
+	VirtualClock::advance(600000);
+	const std::vector<VirtualClock::Write>& w = VirtualClock::getWrites();
+	TEST_ASSERT_TRUE(w.size() > 100);
+	for(size_t i=1;i<w.size();i++){
+		TEST_ASSERT_TRUE(w[i].value >= w[i-1].value);
+		// los pasos son múltiplos del periodo pwm
+		TEST_ASSERT_TRUE((w[i].t_us - w[i-1].t_us) >= PWM_PERIOD_US);
+	}
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_temporal(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	led.on(0, 40);
+	led.off(500);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	VirtualClock::advance(499000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	VirtualClock::advance(1000);
+	TEST_ASSERT_EQUAL(400, last_value(PIN_LED_A));
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_blink_mode(){
+	const uint32_t blink_sequence[] = {100, 200};
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	VirtualClock::clearWrites();
+	uint64_t t0 = VirtualClock::now();
+	TEST_ASSERT_EQUAL(0, led.setBlinkMode(blink_sequence, 2));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(t0 + 100000, last_time(PIN_LED_A));
+	VirtualClock::advance(200000);
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(t0 + 300000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(-1, led.setBlinkMode(blink_sequence, 17));
+	led.cancelBlinkMode();
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_single_timer(){
+	VirtualClock::reset();
+	uint32_t tickers = VirtualClock::getActiveTickers();
+	LedScheduler sched;
+	Led* bank[BANK_COUNT];
+	for(int i=0;i<BANK_COUNT;i++){
+		bank[i] = new Led(PIN_LED_BANK + i, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+		bank[i]->blink(250, 250);
+	}
+	// todos los leds comparten el timer del planificador
+	TEST_ASSERT_EQUAL(tickers + 1, VirtualClock::getActiveTickers());
+	VirtualClock::clearWrites();
+	VirtualClock::advance(1000000);
+	TEST_ASSERT_EQUAL(BANK_COUNT * 4, VirtualClock::getWriteCount());
+	// los flancos simultáneos se atienden en una única interrupción
+	TEST_ASSERT_EQUAL(4, VirtualClock::getCallbackCount());
+	for(int i=0;i<BANK_COUNT;i++){
+		delete(bank[i]);
+	}
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_static_output(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	LedT<LedPwmOutput, LedActiveLow> pwm(PIN_LED_A, PWM_PERIOD_MS, NULL, &sched);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	pwm.on(0, 25);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US - 250, last_value(PIN_LED_A));
+	LedT<LedDigitalOutput> digital(PIN_LED_B, 0, NULL, &sched);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_B));
+	digital.blink(100, 100);
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_B));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_B));
+	// el destructor se puede invocar a través de la fachada
+	Led* led = new LedT<LedPwmOutput>(PIN_LED_A, PWM_PERIOD_MS, NULL, &sched);
+	led->blink(10, 10);
+	delete(led);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	digital.off();
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_static_storage(){
+	VirtualClock::reset();
+	LedSchedulerT<1 + (2 * Led::EventsPerLed)> sched;
+	// el planificador debe admitir los eventos de todos los leds
+	LedSchedulerT<8> small;
+	TEST_ASSERT_EQUAL(-1, led_storage.init(led_cfg, 2, &small));
+	TEST_ASSERT_EQUAL(0, led_storage.size());
+	TEST_ASSERT_EQUAL(0, led_storage.init(led_cfg, 2, &sched));
+	TEST_ASSERT_EQUAL(-1, led_storage.init(led_cfg, 2, &sched));
+	TEST_ASSERT_EQUAL(2, led_storage.size());
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_B));
+	led_storage[0].blink(100, 100);
+	led_storage[1].on(0, 100, 10);
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_B));
+	led_storage.deinit();
+	TEST_ASSERT_EQUAL(0, led_storage.size());
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_command_queue(){
+	static const uint32_t blink_sequence[] = {100, 200};
+	VirtualClock::reset();
+	LedSchedulerT<8> sched;
+	LedCommandQueueT<4> queue;
+	sched.attachQueue(&queue);
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	// los comandos no modifican la salida hasta la siguiente pasada del planificador
+	VirtualClock::clearWrites();
+	led.on(0, 50);
+	led.off(0, 25);
+	TEST_ASSERT_EQUAL(0, VirtualClock::getWriteCount(PIN_LED_A));
+	TEST_ASSERT_EQUAL(1, sched.pending());
+	VirtualClock::advance(1);
+	TEST_ASSERT_EQUAL(250, last_value(PIN_LED_A));
+	// ambos comandos se aplican en la misma pasada: una única escritura
+	TEST_ASSERT_EQUAL(1, VirtualClock::getWriteCount(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	// cola llena: el comando se descarta
+	for(int i=0;i<4;i++){
+		TEST_ASSERT_EQUAL(0, led.setBlinkMode(blink_sequence, 2));
+	}
+	TEST_ASSERT_EQUAL(-1, led.setBlinkMode(blink_sequence, 2));
+	TEST_ASSERT_EQUAL(1, queue.getDropped());
+	// el resto de órdenes también informan del descarte
+	TEST_ASSERT_EQUAL(-1, led.on(0, 50));
+	TEST_ASSERT_EQUAL(-1, led.blink(100, 100));
+	TEST_ASSERT_EQUAL(-1, led.cancelBlinkMode());
+	TEST_ASSERT_EQUAL(4, queue.getDropped());
+	VirtualClock::advance(1);
+	uint64_t t0 = VirtualClock::now();
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(t0 + 100000, last_time(PIN_LED_A));
+	led.cancelBlinkMode();
+	VirtualClock::advance(1);
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+/** Desviación del último cambio de un pin respecto a su instante ideal
+ *  @param pin Pin
+ *  @param t0 Instante del primer cambio
+ *  @param edges Nº de cambios realizados desde t0
+ *  @param times Duración de cada tramo de la secuencia en us
+ *  @param count Nº de tramos de la secuencia
+ */
+static int64_t drift_us(int pin, uint64_t t0, uint32_t edges, const uint32_t* times, int count){
+	uint64_t cycle = 0;
+	for(int i=0;i<count;i++){
+		cycle += times[i];
+	}
+	uint32_t k = edges - 1;
+	uint64_t ideal = t0 + ((k / count) * cycle);
+	for(uint32_t i=0;i<(k % count);i++){
+		ideal += times[i];
+	}
+	return (int64_t)(last_time(pin) - ideal);
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_drift_24h(){
+	static const uint32_t blink_times[] = {250000, 250000};
+	static const uint32_t mode_ms[] = {100, 200, 100, 600};
+	static const uint32_t mode_times[] = {100000, 200000, 100000, 600000};
+	VirtualClock::reset();
+	LedSchedulerT<8> sched;
+	Led led(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	Led led_mode(PIN_LED_B, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	VirtualClock::clearWrites();
+	VirtualClock::setLatency(DRIFT_LATENCY_US);
+	uint64_t t0 = VirtualClock::now();
+	RelativeBlinker legacy(PIN_LED_C, 250000);
+	led.blink(250, 250);
+	led_mode.setBlinkMode(mode_ms, 4);
+	// se avanza por horas para limitar el registro de escrituras
+	uint32_t edges[3] = {0, 0, 0};
+	for(int h=0;h<DRIFT_HOURS;h++){
+		VirtualClock::advance(3600ULL * 1000000ULL);
+		edges[0] += VirtualClock::getWriteCount(PIN_LED_A);
+		edges[1] += VirtualClock::getWriteCount(PIN_LED_B);
+		edges[2] += VirtualClock::getWriteCount(PIN_LED_C);
+		if(h < (DRIFT_HOURS - 1)){
+			VirtualClock::clearWrites();
+		}
+	}
+	int64_t drift_abs = drift_us(PIN_LED_A, t0, edges[0], blink_times, 2);
+	int64_t drift_mode = drift_us(PIN_LED_B, t0, edges[1], mode_times, 4);
+	int64_t drift_rel = drift_us(PIN_LED_C, t0, edges[2], blink_times, 2);
+	printf("  deriva en %dh con latencia de %dus: relativo %lld us, absoluto %lld us, blink mode %lld us\n",
+			DRIFT_HOURS, DRIFT_LATENCY_US, (long long)drift_rel, (long long)drift_abs, (long long)drift_mode);
+	// el error de fase queda acotado por la latencia de una interrupción
+	TEST_ASSERT_TRUE(drift_abs >= 0 && drift_abs <= DRIFT_LATENCY_US);
+	TEST_ASSERT_TRUE(drift_mode >= 0 && drift_mode <= DRIFT_LATENCY_US);
+	TEST_ASSERT_EQUAL(4 * 3600 * DRIFT_HOURS, edges[0]);
+	// con rearme relativo la latencia se acumula en cada cambio
+	TEST_ASSERT_TRUE(drift_rel > (int64_t)(edges[2] - 1) * (DRIFT_LATENCY_US / 2));
+	VirtualClock::setLatency(0);
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_group(){
+	VirtualClock::reset();
+	LedSchedulerT<8> sched;
+	LedGroupT<4> group(&sched);
+	Led red(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	Led green(PIN_LED_B, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	Led white(PIN_LED_C, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	red.blink(100, 100);
+	TEST_ASSERT_EQUAL(0, group.join(&red));
+	TEST_ASSERT_EQUAL(0, group.join(&green));
+	TEST_ASSERT_EQUAL(2, group.size());
+	// el parpadeo individual se ha detenido
+	VirtualClock::clearWrites();
+	VirtualClock::advance(200000);
+	TEST_ASSERT_EQUAL(0, VirtualClock::getWriteCount(PIN_LED_A));
+	uint64_t t0 = VirtualClock::now();
+	TEST_ASSERT_EQUAL(0, group.blink(250, 250));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_B));
+	// un único evento por flanco para todos los miembros
+	VirtualClock::clearWrites();
+	VirtualClock::advance(1000000);
+	TEST_ASSERT_EQUAL(4, VirtualClock::getCallbackCount());
+	TEST_ASSERT_EQUAL(4, VirtualClock::getWriteCount(PIN_LED_A));
+	TEST_ASSERT_EQUAL(4, VirtualClock::getWriteCount(PIN_LED_B));
+	TEST_ASSERT_EQUAL(t0 + 1000000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(t0 + 1000000, last_time(PIN_LED_B));
+	TEST_ASSERT_EQUAL(1, sched.pending());
+	// un miembro que se une a mitad de ciclo toma la fase común
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, group.join(&white));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_C));
+	VirtualClock::advance(150000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_C));
+	TEST_ASSERT_EQUAL(t0 + 1250000, last_time(PIN_LED_C));
+	// desfase por miembro
+	TEST_ASSERT_EQUAL(0, group.leave(&white));
+	TEST_ASSERT_EQUAL(-1, group.leave(&white));
+	TEST_ASSERT_EQUAL(0, group.join(&white, 125));
+	VirtualClock::advance(250000 + 125000);
+	TEST_ASSERT_EQUAL(t0 + 1625000, last_time(PIN_LED_C));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_C));
+	// una orden individual saca al led del grupo
+	green.on();
+	TEST_ASSERT_EQUAL(2, group.size());
+	VirtualClock::advance(1000000);
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_B));
+	group.stop();
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_bank(){
+	static const uint32_t blink_sequence[] = {100, 200};
+	LedBankT<4> bank(1000);
+	uint32_t t = 0;
+	TEST_ASSERT_EQUAL(0, bank.update(t));
+	// rampa de 100 tramas: monotónica y con el valor final exacto en la última
+	bank.on(0, 0, 100, 100);
+	bank.blink(1, 10, 20);
+	TEST_ASSERT_EQUAL(0, bank.setBlinkMode(2, blink_sequence, 2));
+	TEST_ASSERT_EQUAL(-1, bank.setBlinkMode(3, blink_sequence, 17));
+	bank.on(3, 50);
+	uint16_t prev = 0;
+	uint32_t edges = 0;
+	for(int f=1;f<=300;f++){
+		t += 1000;
+		uint16_t n = bank.update(t);
+		for(uint16_t k=0;k<n;k++){
+			edges += (bank.changed()[k] == 1)? 1 : 0;
+		}
+		TEST_ASSERT_TRUE(bank.value(0) >= prev);
+		prev = bank.value(0);
+		if(f == 99){
+			TEST_ASSERT_TRUE(bank.value(0) < 0xFFFF);
+		}
+		if(f == 100){
+			TEST_ASSERT_EQUAL(0xFFFF, bank.value(0));
+		}
+		// parpadeo 10/20ms
+		if(f == 10 || f == 40){
+			TEST_ASSERT_EQUAL(0, bank.value(1));
+		}
+		if(f == 30 || f == 60){
+			TEST_ASSERT_EQUAL(0xFFFF, bank.value(1));
+		}
+		// modo blink 100/200ms
+		if(f == 99){
+			TEST_ASSERT_EQUAL(0xFFFF, bank.value(2));
+		}
+		if(f == 100 || f == 299){
+			TEST_ASSERT_EQUAL(0, bank.value(2));
+		}
+		if(f == 300){
+			TEST_ASSERT_EQUAL(0xFFFF, bank.value(2));
+		}
+		// estado temporal de 50ms: vuelve a apagado
+		if(f == 49){
+			TEST_ASSERT_EQUAL(0xFFFF, bank.value(3));
+		}
+		if(f == 50){
+			TEST_ASSERT_EQUAL(0, bank.value(3));
+		}
+	}
+	// encendido inicial y 300ms con periodo de 30ms: 1 + 20 cambios
+	TEST_ASSERT_EQUAL(21, edges);
+	bank.cancelBlinkMode(2);
+	bank.update(t + 1000);
+	TEST_ASSERT_EQUAL(0, bank.value(2));
+	// lista vacía durante un estado temporal que debía restaurar el modo blink
+	t += 1000;
+	TEST_ASSERT_EQUAL(0, bank.setBlinkMode(2, blink_sequence, 2));
+	bank.on(2, 50);
+	TEST_ASSERT_EQUAL(0, bank.setBlinkMode(2, NULL, 0));
+	TEST_ASSERT_EQUAL(0, bank.setBlinkMode(3, blink_sequence, 2));
+	TEST_ASSERT_EQUAL(0, bank.setBlinkMode(3, NULL, 0));
+	for(int f=1;f<=300;f++){
+		t += 1000;
+		bank.update(t);
+	}
+	TEST_ASSERT_EQUAL(0, bank.value(2));
+	TEST_ASSERT_EQUAL(0, bank.value(3));
+}
+
+
+//------------------------------------------------------------------------------------
+/** Tiempo activo de un bit del puerto en una ventana de una trama (la señal es periódica: el resultado
+ *  no depende del inicio de la ventana). El registro debe contener la escritura previa a t0
+ *  @param bit Bit del puerto
+ *  @param t0 Inicio de la ventana
+ *  @param frame_us Duración de la trama
+ */
+static uint32_t bam_on_time(int bit, uint64_t t0, uint32_t frame_us){
+	const std::vector<VirtualClock::Write>& w = VirtualClock::getWrites();
+	uint64_t t1 = t0 + frame_us;
+	uint64_t t = t0;
+	int value = 0;
+	uint32_t on_us = 0;
+	for(size_t i=0;i<w.size();i++){
+		if(w[i].pin != PORT_BAM){
+			continue;
+		}
+		if(w[i].t_us > t){
+			uint64_t end = (w[i].t_us < t1)? w[i].t_us : t1;
+			on_us += (value & (1 << bit))? (uint32_t)(end - t) : 0;
+			t = end;
+		}
+		if(w[i].t_us >= t1){
+			break;
+		}
+		value = w[i].value;
+	}
+	on_us += (value & (1 << bit))? (uint32_t)(t1 - t) : 0;
+	return on_us;
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_bam(){
+	VirtualClock::reset();
+	LedSchedulerT<8> sched;
+	LedBam bam(PORT_BAM, 0x0030, 8, BAM_LSB_US, &sched);
+	Led red(&bam, 4, Led::OnIsHighLevel, NULL, &sched);
+	Led green(&bam, 5, Led::OnIsLowLevel, NULL, &sched);
+	uint32_t frame_us = bam.getFramePeriod();
+	TEST_ASSERT_EQUAL(255 * BAM_LSB_US, frame_us);
+	TEST_ASSERT_EQUAL(-1, bam.setDuty(3, 10));
+	// red al 50% y green (activo a nivel bajo) al 25%: una escritura por intervalo
+	red.on(0, 50);
+	green.on(0, 25);
+	VirtualClock::advance(frame_us);
+	VirtualClock::clearWrites();
+	VirtualClock::advance(frame_us);
+	TEST_ASSERT_EQUAL(8, VirtualClock::getWriteCount(PORT_BAM));
+	uint64_t t0 = VirtualClock::now() - (frame_us / 2);
+	VirtualClock::advance(frame_us);
+	TEST_ASSERT_EQUAL(128 * BAM_LSB_US, bam_on_time(4, t0, frame_us));
+	TEST_ASSERT_EQUAL((255 - 64) * BAM_LSB_US, bam_on_time(5, t0, frame_us));
+	// rampa sobre una salida digital
+	red.off(0, 0, 200);
+	green.off();
+	VirtualClock::advance(100000);
+	VirtualClock::clearWrites();
+	VirtualClock::advance(frame_us);
+	t0 = VirtualClock::now();
+	VirtualClock::advance(frame_us);
+	uint32_t mid = bam_on_time(4, t0, frame_us);
+	TEST_ASSERT_TRUE(mid > 0 && mid < (128 * BAM_LSB_US));
+	TEST_ASSERT_EQUAL(frame_us, bam_on_time(5, t0, frame_us));
+	// con todos los canales a 0 la modulación se detiene (green activo a nivel bajo sigue modulando)
+	green.on();
+	VirtualClock::advance(200000);
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	TEST_ASSERT_EQUAL(0, VirtualClock::getLastWrite(PORT_BAM)->value);
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_shadow(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	TEST_ASSERT_EQUAL(1, led.getWritesIssued());
+	// órdenes sin cambio de intensidad: no generan escritura
+	VirtualClock::clearWrites();
+	led.off();
+	led.on();
+	led.on();
+	TEST_ASSERT_EQUAL(1, VirtualClock::getWriteCount(PIN_LED_A));
+	TEST_ASSERT_EQUAL(2, led.getWritesSuppressed());
+	// el estado temporal restaura la misma intensidad
+	led.on(100);
+	VirtualClock::advance(150000);
+	TEST_ASSERT_EQUAL(1, VirtualClock::getWriteCount(PIN_LED_A));
+	TEST_ASSERT_EQUAL(4, led.getWritesSuppressed());
+	// fin del estado temporal y flanco del parpadeo en el mismo instante: una única escritura
+	led.blink(100, 100, 200);
+	VirtualClock::clearWrites();
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(1, VirtualClock::getWriteCount(PIN_LED_A));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(2, VirtualClock::getWriteCount(PIN_LED_A));
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	TEST_ASSERT_EQUAL(4, led.getWritesIssued());
+	TEST_ASSERT_EQUAL(5, led.getWritesSuppressed());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_pattern(){
+	static constexpr LedPatternOp blink_ops[] = {
+		LedPatternOp::set(100, 100),
+		LedPatternOp::set(0, 100),
+		LedPatternOp::loop(2, 0),
+		LedPatternOp::ramp(50, 200),
+		LedPatternOp::hold(100),
+		LedPatternOp::jump(0),
+	};
+	static constexpr LedPattern blink_pattern(blink_ops, 6);
+	static constexpr LedPatternOp end_ops[] = { LedPatternOp::set(30, 50), LedPatternOp::end() };
+	static constexpr LedPattern end_pattern(end_ops, 2);
+	static constexpr LedPatternOp empty_ops[] = { LedPatternOp::set(100), LedPatternOp::jump(0) };
+	static constexpr LedPattern empty_pattern(empty_ops, 2);
+	static const uint32_t long_blinks[] = {100, 70000};
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led_a(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	Led led_b(PIN_LED_B, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	// ambos leds ejecutan el mismo patrón por referencia
+	led_a.play(&blink_pattern);
+	led_b.play(&blink_pattern);
+	static const uint32_t at_ms[] = {0, 100, 200, 300, 600, 700};
+	static const int value[] = {PWM_PERIOD_US, 0, PWM_PERIOD_US, 0, PWM_PERIOD_US / 2, PWM_PERIOD_US};
+	uint64_t t0 = VirtualClock::now();
+	for(int i=0;i<6;i++){
+		VirtualClock::advanceTo(t0 + (at_ms[i] * 1000));
+		TEST_ASSERT_INT_WITHIN(3, value[i], last_value(PIN_LED_A));
+		TEST_ASSERT_EQUAL(last_value(PIN_LED_A), last_value(PIN_LED_B));
+	}
+	// la rampa termina exactamente al vencer la instrucción
+	VirtualClock::clearWrites();
+	VirtualClock::advanceTo(t0 + 1100000);
+	TEST_ASSERT_EQUAL(t0 + 1000000, last_time(PIN_LED_A));
+	// una orden temporal suspende el patrón; al finalizar se reanuda
+	led_a.on(50, 20);
+	VirtualClock::advance(40000);
+	TEST_ASSERT_EQUAL(200, last_value(PIN_LED_A));
+	VirtualClock::advance(10000);
+	TEST_ASSERT_INT_WITHIN(3, PWM_PERIOD_US / 2, last_value(PIN_LED_A));
+	// fin del patrón: el led conserva el nivel
+	led_a.play(&end_pattern);
+	led_b.play(&empty_pattern);
+	VirtualClock::advance(100000);
+	TEST_ASSERT_INT_WITHIN(3, (PWM_PERIOD_US * 30) / 100, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_B));
+	// un patrón sin instrucciones que consuman tiempo se detiene
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	TEST_ASSERT_EQUAL(-1, led_a.setBlinkMode(long_blinks, 2));
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_pattern_registry(){
+	static const uint32_t two_blinks[] = {150, 150, 150, 850};
+	static const uint32_t one_blink[] = {150, 850};
+	VirtualClock::reset();
+	// patrones idénticos comparten una única copia
+	LedPatternRegistryT<2, 8> registry;
+	LedPatternHandle h = registry.intern(two_blinks, 4);
+	TEST_ASSERT_TRUE(h != NULL);
+	TEST_ASSERT_TRUE(h == registry.intern(two_blinks, 4));
+	TEST_ASSERT_EQUAL(1, registry.size());
+	TEST_ASSERT_EQUAL(5, registry.getUsedOps());
+	// sin espacio en el pool
+	TEST_ASSERT_TRUE(registry.intern(one_blink, 2) != NULL);
+	TEST_ASSERT_TRUE(registry.intern(two_blinks, 3) == NULL);
+	TEST_ASSERT_EQUAL(2, registry.size());
+
+	// la lista de setBlinkMode se registra una vez para toda la flota
+	LedScheduler sched;
+	Led* fleet[BANK_COUNT];
+	uint16_t patterns = LedPatternRegistry::getDefault()->size();
+	for(int i=0;i<BANK_COUNT;i++){
+		fleet[i] = new Led(PIN_LED_BANK + i, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+		TEST_ASSERT_EQUAL(0, fleet[i]->setBlinkMode(two_blinks, 4));
+	}
+	TEST_ASSERT_TRUE(LedPatternRegistry::getDefault()->size() <= (patterns + 1));
+	LedPatternHandle shared = LedPatternRegistry::getDefault()->intern(two_blinks, 4);
+	TEST_ASSERT_EQUAL(BANK_COUNT + 1, LedPatternRegistry::getDefault()->getRefs(shared));
+	LedPatternRegistry::getDefault()->release(shared);
+	// cambio de patrón de toda la flota: una asignación de handle por led
+	VirtualClock::advance(50000);
+	for(int i=0;i<BANK_COUNT;i++){
+		fleet[i]->play(h);
+	}
+	VirtualClock::clearWrites();
+	VirtualClock::advance(1300000);
+	TEST_ASSERT_EQUAL(BANK_COUNT * 4, VirtualClock::getWriteCount());
+	for(int i=0;i<BANK_COUNT;i++){
+		delete(fleet[i]);
+	}
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	TEST_ASSERT_EQUAL(0, LedPatternRegistry::getDefault()->getRefs(shared));
+
+	// cada lista nueva libera la anterior: un led recorre más listas que entradas tiene el registro
+	Led led(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, 0, NULL, &sched);
+	uint32_t list[2] = {0, 100};
+	for(int i=0;i<(2 * LedPatternRegistry::DefaultMaxPatterns);i++){
+		list[0] = 100 + i;
+		TEST_ASSERT_EQUAL(0, led.setBlinkMode(list, 2));
+		VirtualClock::advance(50000);
+		TEST_ASSERT_EQUAL(0, led.stageBlinkMode(list, 2));
+		VirtualClock::advance(250000);
+	}
+	TEST_ASSERT_TRUE(LedPatternRegistry::getDefault()->size() <= (patterns + 4));
+
+	// una entrada sin referencias se reutiliza para un patrón que cabe en sus instrucciones
+	TEST_ASSERT_EQUAL(2, registry.getRefs(h));
+	registry.release(h);
+	registry.release(h);
+	TEST_ASSERT_EQUAL(0, registry.getRefs(h));
+	TEST_ASSERT_TRUE(registry.intern(two_blinks, 3) == h);
+	TEST_ASSERT_EQUAL(1, registry.getRefs(h));
+	TEST_ASSERT_EQUAL(2, registry.size());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_layers(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	led.on(0, 33, 200);
+	VirtualClock::advance(300000);
+	int base = last_value(PIN_LED_A);
+	uint64_t t0 = VirtualClock::now();
+	// notificación de 1s y alarma de 2s sobre ella, cada una con su propia expiración
+	led.blink(100, 100, 1000);
+	VirtualClock::advance(50000);
+	led.on(2000, 70, 0, Led::LayerAlarm);
+	TEST_ASSERT_EQUAL((PWM_PERIOD_US * 70) / 100, last_value(PIN_LED_A));
+	// la notificación expira oculta por la alarma: no se reevalúa la salida
+	VirtualClock::clearWrites();
+	VirtualClock::advanceTo(t0 + 1500000);
+	TEST_ASSERT_EQUAL(0, VirtualClock::getWriteCount());
+	// al expirar la alarma reaparece la capa base con su nivel exacto
+	VirtualClock::advanceTo(t0 + 2100000);
+	TEST_ASSERT_EQUAL(1, VirtualClock::getWriteCount());
+	TEST_ASSERT_EQUAL(t0 + 2050000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(base, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	// la alarma expira antes que la notificación: reaparece la notificación
+	led.blink(100, 100, 1000);
+	led.on(250, 100, 0, Led::LayerAlarm);
+	VirtualClock::advance(250000);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// una orden sin duración descarta las capas hasta su prioridad
+	led.on(5000, 100, 0, Led::LayerAlarm);
+	led.off();
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	led.off(0, 0, 0, Led::LayerAlarm);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_trace(){
+	static uint8_t buf[LedTrace::DumpMaxSize];
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	LedTrace::clear();
+	// desactivado en ejecución no se registra nada
+	led.on();
+	LedTraceHeader hdr;
+	TEST_ASSERT_EQUAL(sizeof(LedTraceHeader), LedTrace::dump(buf, sizeof(buf)));
+	LedTrace::enable(true);
+	uint32_t t0 = (uint32_t)VirtualClock::now();
+	led.off(0, 0, 0, Led::LayerAlarm);
+	led.blink(100, 100, 300);
+	VirtualClock::advance(150000);
+	uint32_t size = LedTrace::dump(buf, sizeof(buf));
+	memcpy(&hdr, buf, sizeof(hdr));
+	TEST_ASSERT_EQUAL(LedTrace::Magic, hdr.magic);
+	TEST_ASSERT_EQUAL(1000000, hdr.tick_hz);
+	TEST_ASSERT_EQUAL(0, hdr.lost);
+	TEST_ASSERT_EQUAL(sizeof(LedTraceHeader) + (hdr.count * sizeof(LedTraceRecord)), size);
+	// línea de tiempo: llamadas, callbacks y escrituras con su instante y el id del led
+	static const uint8_t events[] = {LedTrace::EvOff, LedTrace::EvWrite, LedTrace::EvBlink, LedTrace::EvWrite, LedTrace::EvBlinkCb, LedTrace::EvWrite};
+	static const uint32_t at_us[] = {0, 0, 0, 0, 100000, 100000};
+	TEST_ASSERT_EQUAL(6, hdr.count);
+	for(uint32_t i=0;i<hdr.count;i++){
+		LedTraceRecord r;
+		memcpy((void*)&r, buf + sizeof(hdr) + (i * sizeof(r)), sizeof(r));
+		TEST_ASSERT_EQUAL(events[i], r.event);
+		TEST_ASSERT_EQUAL(t0 + at_us[i], r.ticks);
+		TEST_ASSERT_EQUAL(PIN_LED_A, r.id);
+	}
+	TEST_ASSERT_TRUE(strcmp("blinkCb", LedTrace::getEventName(events[4])) == 0);
+	// buffer lleno: se conservan los registros más recientes
+	for(uint32_t i=0;i<LedTrace::Size;i++){
+		LedTrace::record(LedTrace::EvWrite, PIN_LED_B, (uint16_t)i);
+	}
+	LedTrace::dump(buf, sizeof(buf));
+	memcpy(&hdr, buf, sizeof(hdr));
+	TEST_ASSERT_EQUAL(LedTrace::Size, hdr.count);
+	TEST_ASSERT_EQUAL(6, hdr.lost);
+	LedTraceRecord last;
+	memcpy((void*)&last, buf + sizeof(hdr) + ((hdr.count - 1) * sizeof(last)), sizeof(last));
+	TEST_ASSERT_EQUAL(LedTrace::Size - 1, last.arg);
+	LedTrace::enable(false);
+	LedTrace::clear();
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_stats(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	LedStats storage;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	LedStats stats;
+	// las estadísticas propias son opcionales
+	TEST_ASSERT_EQUAL(-1, led.getStats(stats));
+	led.attachStats(&storage);
+	LedStats global0;
+	TEST_ASSERT_EQUAL(0, Led::getGlobalStats(global0));
+	uint32_t t0 = sched.now();
+	led.on();
+	VirtualClock::advance(300000);
+	// parpadeo con 50us de latencia de interrupción
+	VirtualClock::setLatency(50);
+	led.blink(100, 100);
+	VirtualClock::advance(1000100);
+	VirtualClock::setLatency(0);
+	TEST_ASSERT_EQUAL(0, led.getStats(stats));
+	TEST_ASSERT_EQUAL(10, stats.callbacks[LedStats::CbBlink]);
+	TEST_ASSERT_EQUAL(0, stats.callbacks[LedStats::CbRamp]);
+	TEST_ASSERT_EQUAL(led.getWritesIssued(), stats.writes_issued);
+	TEST_ASSERT_EQUAL(12, stats.writes_issued);
+	// retraso: 50us, intervalo [16,64)
+	TEST_ASSERT_EQUAL(50, stats.lateness.max);
+	TEST_ASSERT_EQUAL(10, stats.lateness.count[3]);
+	// tiempo en cada estado
+	TEST_ASSERT_EQUAL(LedStats::StatBlinking, stats.stat);
+	TEST_ASSERT_EQUAL(300000, stats.time_us[LedStats::StatOn]);
+	TEST_ASSERT_EQUAL(t0 + 300000, stats.stat_since);
+	led.off();
+	TEST_ASSERT_EQUAL(0, led.getStats(stats));
+	TEST_ASSERT_EQUAL(1000100, stats.time_us[LedStats::StatBlinking]);
+	// estadísticas agregadas y del planificador
+	LedStats global;
+	TEST_ASSERT_EQUAL(0, Led::getGlobalStats(global));
+	TEST_ASSERT_EQUAL(10, global.callbacks[LedStats::CbBlink] - global0.callbacks[LedStats::CbBlink]);
+	TEST_ASSERT_EQUAL(1300100, (uint32_t)((global.time_us[LedStats::StatOn] + global.time_us[LedStats::StatBlinking]) -
+	                                      (global0.time_us[LedStats::StatOn] + global0.time_us[LedStats::StatBlinking])));
+	LedSchedulerStats sched_stats;
+	sched_stats.clear();
+	TEST_ASSERT_EQUAL(0, sched.getStats(sched_stats));
+	TEST_ASSERT_EQUAL(10, sched_stats.events);
+	TEST_ASSERT_EQUAL(10, sched_stats.passes);
+	TEST_ASSERT_EQUAL(50, sched_stats.lateness.max);
+	TEST_ASSERT_EQUAL(10, sched_stats.isr_time.count[0]);
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_dithering(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	Led digital(PIN_LED_B, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	TEST_ASSERT_EQUAL(-1, digital.setPeriodUs(10));
+	TEST_ASSERT_EQUAL(-1, digital.setDithering(true));
+	// intensidad de 16 bits: resolución por debajo del 1%
+	led.on(0, LedLevel(0x0148));
+	TEST_ASSERT_EQUAL(5, last_value(PIN_LED_A));
+	// periodo de 10us: sin dithering el ancho de pulso se redondea al microsegundo
+	TEST_ASSERT_EQUAL(0, led.setPeriodUs(10));
+	led.on(0, LedLevel(0x1000));
+	TEST_ASSERT_EQUAL(10, VirtualClock::getLastWrite(PIN_LED_A)->period_us);
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	// con dithering el ancho medio es exacto: 10us * 1/16 = 0.625us
+	TEST_ASSERT_EQUAL(0, led.setDithering(true));
+	VirtualClock::clearWrites();
+	VirtualClock::advance(160);
+	const std::vector<VirtualClock::Write>& w = VirtualClock::getWrites();
+	TEST_ASSERT_EQUAL(16, w.size());
+	int sum = 0;
+	for(size_t i=0;i<w.size();i++){
+		TEST_ASSERT_TRUE(w[i].value == 0 || w[i].value == 1);
+		sum += w[i].value;
+	}
+	TEST_ASSERT_EQUAL(10, sum);
+	// en los extremos no hay ticks
+	led.on(0, LedLevel(0xFFFF));
+	TEST_ASSERT_EQUAL(10, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	led.off(0, LedLevel(0x8000), 100);
+	VirtualClock::advance(200000);
+	TEST_ASSERT_EQUAL(5, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(1, sched.pending());
+	TEST_ASSERT_EQUAL(0, led.setDithering(false));
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_color_led(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	static const PinName32 pins[] = {PIN_LED_A, PIN_LED_B, PIN_LED_C};
+	ColorLed rgb(pins, 3, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	TEST_ASSERT_EQUAL(3, rgb.getChannels());
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// transición: un único evento para todos los canales y escrituras en el mismo tick
+	rgb.setRgb(255, 128, 0, 10);
+	TEST_ASSERT_EQUAL(1, sched.pending());
+	VirtualClock::clearWrites();
+	VirtualClock::advance(5000);
+	const std::vector<VirtualClock::Write>& w = VirtualClock::getWrites();
+	TEST_ASSERT_TRUE(w.size() > 0);
+	for(size_t i=0;i<w.size();i++){
+		TEST_ASSERT_TRUE(w[i].pin != PIN_LED_C);
+	}
+	TEST_ASSERT_EQUAL(last_time(PIN_LED_A), last_time(PIN_LED_B));
+	TEST_ASSERT_INT_WITHIN(2, PWM_PERIOD_US / 2, last_value(PIN_LED_A));
+	TEST_ASSERT_INT_WITHIN(2, PWM_PERIOD_US / 4, last_value(PIN_LED_B));
+	// fin de la transición: destino exacto en todos los canales
+	VirtualClock::advance(5000);
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	TEST_ASSERT_TRUE(rgb.getColor() == LedColor::rgb(255, 128, 0));
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(last_time(PIN_LED_A), last_time(PIN_LED_B));
+	// conversión HSV
+	TEST_ASSERT_TRUE(ColorLed::fromHsv(0, 255, 255) == LedColor::rgb(255, 0, 0));
+	TEST_ASSERT_TRUE(ColorLed::fromHsv(120, 255, 255) == LedColor::rgb(0, 255, 0));
+	TEST_ASSERT_TRUE(ColorLed::fromHsv(240, 255, 255) == LedColor::rgb(0, 0, 255));
+	TEST_ASSERT_TRUE(ColorLed::fromHsv(360, 0, 255) == LedColor::rgb(255, 255, 255));
+	// temperatura de color: tabla e interpolación
+	TEST_ASSERT_TRUE(ColorLed::fromTemperature(6500) == LedColor::rgb(255, 254, 250));
+	TEST_ASSERT_TRUE(ColorLed::fromTemperature(500) == LedColor::rgb(255, 68, 0));
+	LedColor c = ColorLed::fromTemperature(6750, 50);
+	TEST_ASSERT_EQUAL((((249 * 257) * 50) + 50) / 100, c.ch[ColorLed::ChRed]);
+	// parpadeo: un único evento, todos los canales cambian a la vez
+	rgb.blink(LedColor::rgb(0, 0, 255), LedColor(), 100, 100);
+	TEST_ASSERT_EQUAL(1, sched.pending());
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_C));
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_C));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, last_value(PIN_LED_C));
+	rgb.off();
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_C));
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_waveform(){
+	VirtualClock::reset();
+	MockWaveSink sink;
+	LedWaveformT<64> wave(&sink, PWM_PERIOD_US);
+	// parpadeo: un ciclo precalculado que el destino repite sin intervención de la cpu
+	TEST_ASSERT_EQUAL(0, wave.renderBlink(2, 2, 0xFFFF, 0));
+	TEST_ASSERT_EQUAL(4, wave.getLength());
+	sink.run(8);
+	static const uint16_t blink[] = {PWM_PERIOD_US, PWM_PERIOD_US, 0, 0, PWM_PERIOD_US, PWM_PERIOD_US, 0, 0};
+	TEST_ASSERT_EQUAL(8, sink.getOutput().size());
+	TEST_ASSERT_EQUAL(0, memcmp(blink, &sink.getOutput()[0], sizeof(blink)));
+	TEST_ASSERT_EQUAL(1, sink.getAdoptions());
+	// cálculo perezoso: la misma orden no se recalcula
+	TEST_ASSERT_EQUAL(0, wave.renderBlink(2, 2, 0xFFFF, 0));
+	TEST_ASSERT_EQUAL(1, wave.getRenders());
+	// doble buffer: el nuevo ciclo se adopta al final del ciclo en curso
+	sink.clearOutput();
+	sink.run(1);
+	TEST_ASSERT_EQUAL(0, wave.renderBlink(1, 1, 0x8000, 0));
+	TEST_ASSERT_EQUAL(-1, wave.renderBlink(3, 1, 0x8000, 0));
+	sink.run(5);
+	static const uint16_t swap[] = {PWM_PERIOD_US, PWM_PERIOD_US, 0, 0, PWM_PERIOD_US / 2, 0};
+	TEST_ASSERT_EQUAL(0, memcmp(swap, &sink.getOutput()[0], sizeof(swap)));
+	// rampa: termina en el destino exacto y la salida lo mantiene
+	TEST_ASSERT_EQUAL(0, wave.renderLevel(0));
+	sink.run(2);
+	TEST_ASSERT_EQUAL(0, wave.renderRamp(0xFFFF, 10));
+	TEST_ASSERT_EQUAL(11, wave.getLength());
+	sink.clearOutput();
+	sink.run(20);
+	const std::vector<uint16_t>& out = sink.getOutput();
+	TEST_ASSERT_EQUAL(0, out[0]);
+	for(size_t i=1;i<out.size();i++){
+		TEST_ASSERT_TRUE(out[i] >= out[i - 1]);
+	}
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, out[10]);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, out[19]);
+	TEST_ASSERT_EQUAL(-1, wave.renderRamp(0, 100));
+	// patrón cíclico (jump(0)): una pasada calculada y repetida por el destino
+	static constexpr LedPatternOp ops[] = {
+		LedPatternOp::set(100, 1),
+		LedPatternOp::ramp(0, 2),
+		LedPatternOp::jump(0),
+	};
+	static constexpr LedPattern pattern(ops, 3);
+	TEST_ASSERT_EQUAL(0, wave.renderPattern(&pattern));
+	TEST_ASSERT_EQUAL(3, wave.getLength());
+	sink.clearOutput();
+	sink.run(7);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, out[0]);
+	TEST_ASSERT_INT_WITHIN(2, PWM_PERIOD_US / 2, out[2]);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, out[3]);
+	TEST_ASSERT_EQUAL(out[2], out[5]);
+	TEST_ASSERT_EQUAL(PWM_PERIOD_US, out[6]);
+	// nivel lógico invertido
+	MockWaveSink sink_low;
+	LedWaveformT<4> low(&sink_low, PWM_PERIOD_US, Led::OnIsLowLevel);
+	TEST_ASSERT_EQUAL(0, low.renderLevel(0xFFFF));
+	sink_low.run(1);
+	TEST_ASSERT_EQUAL(0, sink_low.getOutput()[0]);
+	TEST_ASSERT_EQUAL(-1, low.renderBlink(4, 1, 0xFFFF, 0));
+}
+
+
+//------------------------------------------------------------------------------------
+static uint64_t slack_probe_t;
+static void slack_probe_cb(){
+	slack_probe_t = VirtualClock::now();
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_scheduler_slack(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led a(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	Led b(PIN_LED_B, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	// sin tolerancia: cada led despierta al procesador en sus propios flancos
+	uint64_t t0 = VirtualClock::now();
+	a.blink(100, 100);
+	VirtualClock::advance(3000);
+	b.blink(100, 100);
+	LedSchedulerStats st;
+	st.clear();
+	TEST_ASSERT_EQUAL(0, sched.getStats(st));
+	uint32_t passes = st.passes;
+	VirtualClock::advanceTo(t0 + 1000000 + 4000);
+	TEST_ASSERT_EQUAL(0, sched.getStats(st));
+	TEST_ASSERT_EQUAL(20, st.passes - passes);
+	TEST_ASSERT_EQUAL(t0 + 1000000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(t0 + 1003000, last_time(PIN_LED_B));
+	// con tolerancia de 5ms las ventanas se solapan: un único despertar por pareja de flancos
+	a.setSlack(5000);
+	b.setSlack(5000);
+	// (el evento ya armado para el siguiente flanco puede no agruparse)
+	VirtualClock::advanceTo(t0 + 1100000 + 10000);
+	TEST_ASSERT_EQUAL(0, sched.getStats(st));
+	passes = st.passes;
+	VirtualClock::advanceTo(t0 + 2000000 + 8000);
+	TEST_ASSERT_EQUAL(0, sched.getStats(st));
+	TEST_ASSERT_EQUAL(9, st.passes - passes);
+	TEST_ASSERT_EQUAL(t0 + 2005000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(last_time(PIN_LED_A), last_time(PIN_LED_B));
+	// deadlines absolutos: el retraso no se acumula
+	VirtualClock::advanceTo(t0 + 12000000 + 8000);
+	TEST_ASSERT_EQUAL(t0 + 12005000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, sched.getStats(st));
+	TEST_ASSERT_EQUAL(5000, st.lateness.max);
+	// un evento sin tolerancia no se retrasa por la de otro
+	b.setSlack(0);
+	b.blink(100, 100);
+	uint64_t tb = VirtualClock::now();
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(tb + 100000, last_time(PIN_LED_B));
+	a.off();
+	b.off();
+	// sin eventos pendientes no hay despertares
+	TEST_ASSERT_EQUAL(0, sched.getStats(st));
+	passes = st.passes;
+	VirtualClock::advance(10000000);
+	TEST_ASSERT_EQUAL(0, sched.getStats(st));
+	TEST_ASSERT_EQUAL(passes, st.passes);
+
+	// el rearme evalúa un nº acotado de eventos: un evento sin tolerancia fuera del recorrido tampoco se retrasa
+	static LedScheduler::Event events[200];
+	static LedScheduler::Event probe;
+	LedScheduler many(256);
+	for(int i=0;i<200;i++){
+		events[i].slack = 50000;
+		TEST_ASSERT_EQUAL(0, many.schedule(&events[i], callback(slack_probe_cb), 1000 + (i * 10)));
+	}
+	uint64_t tp = VirtualClock::now() + 4000;
+	TEST_ASSERT_EQUAL(0, many.schedule(&probe, callback(slack_probe_cb), 4000));
+	VirtualClock::advance(4000);
+	TEST_ASSERT_EQUAL(tp, slack_probe_t);
+	VirtualClock::advance(60000);
+	TEST_ASSERT_EQUAL(0, many.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_stage(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	// parpadeo: el cambio preparado se adopta al completar el ciclo, no a mitad
+	uint64_t t0 = VirtualClock::now();
+	led.blink(100, 100);
+	VirtualClock::advance(30000);
+	TEST_ASSERT_EQUAL(0, led.stageBlinker(50, 50));
+	VirtualClock::advanceTo(t0 + 150000);
+	TEST_ASSERT_EQUAL(t0 + 100000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	VirtualClock::advanceTo(t0 + 260000);
+	TEST_ASSERT_EQUAL(t0 + 250000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// en el siguiente flanco; el segundo cambio sustituye al primero
+	TEST_ASSERT_EQUAL(0, led.stageBlinker(200, 200, Led::SwapAtEdge));
+	TEST_ASSERT_EQUAL(0, led.stageBlinker(20, 80, Led::SwapAtEdge));
+	VirtualClock::advanceTo(t0 + 300000);
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	VirtualClock::advanceTo(t0 + 320000);
+	TEST_ASSERT_EQUAL(t0 + 320000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// updateBlinker: ambos tiempos a la vez en el siguiente flanco
+	led.updateBlinker(10, 10);
+	VirtualClock::advanceTo(t0 + 400000);
+	TEST_ASSERT_EQUAL(t0 + 400000, last_time(PIN_LED_A));
+	VirtualClock::advanceTo(t0 + 415000);
+	TEST_ASSERT_EQUAL(t0 + 410000, last_time(PIN_LED_A));
+	// patrón: el patrón nuevo comienza al completar la pasada, encadenado con el deadline anterior
+	static constexpr LedPatternOp slow_ops[] = {
+		LedPatternOp::set(100, 100),
+		LedPatternOp::set(0, 100),
+		LedPatternOp::jump(0),
+	};
+	static constexpr LedPatternOp fast_ops[] = {
+		LedPatternOp::set(100, 40),
+		LedPatternOp::set(0, 40),
+		LedPatternOp::jump(0),
+	};
+	static constexpr LedPattern slow(slow_ops, 3);
+	static constexpr LedPattern fast(fast_ops, 3);
+	uint64_t t1 = VirtualClock::now();
+	led.play(&slow);
+	VirtualClock::advance(50000);
+	TEST_ASSERT_EQUAL(0, led.stagePattern(&fast));
+	VirtualClock::advanceTo(t1 + 190000);
+	TEST_ASSERT_EQUAL(t1 + 100000, last_time(PIN_LED_A));
+	VirtualClock::advanceTo(t1 + 210000);
+	TEST_ASSERT_EQUAL(t1 + 200000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	VirtualClock::advanceTo(t1 + 250000);
+	TEST_ASSERT_EQUAL(t1 + 240000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// de patrón a parpadeo en el límite de la pasada
+	TEST_ASSERT_EQUAL(0, led.stageBlinker(30, 30));
+	VirtualClock::advanceTo(t1 + 285000);
+	TEST_ASSERT_EQUAL(t1 + 280000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	VirtualClock::advanceTo(t1 + 315000);
+	TEST_ASSERT_EQUAL(t1 + 310000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(0, last_value(PIN_LED_A));
+	// de parpadeo a patrón (lista de setBlinkMode)
+	static const uint32_t blinks[] = {70, 70};
+	TEST_ASSERT_EQUAL(0, led.stageBlinkMode(blinks, 2));
+	VirtualClock::advanceTo(t1 + 345000);
+	TEST_ASSERT_EQUAL(t1 + 340000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	VirtualClock::advanceTo(t1 + 415000);
+	TEST_ASSERT_EQUAL(t1 + 410000, last_time(PIN_LED_A));
+	// updateBlinker no sustituye a la lista en ejecución
+	led.updateBlinker(5, 5);
+	VirtualClock::advanceTo(t1 + 500000);
+	TEST_ASSERT_EQUAL(t1 + 480000, last_time(PIN_LED_A));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	TEST_ASSERT_EQUAL(-1, led.stageBlinkMode(blinks, 0));
+	TEST_ASSERT_EQUAL(-1, led.stagePattern(NULL));
+	// una orden nueva descarta el cambio preparado
+	led.blink(100, 100);
+	uint64_t t2 = VirtualClock::now();
+	TEST_ASSERT_EQUAL(0, led.stageBlinker(10, 10));
+	led.blink(100, 100);
+	VirtualClock::advance(250000);
+	TEST_ASSERT_EQUAL(t2 + 200000, last_time(PIN_LED_A));
+	// led sin actividad: se aplica directamente
+	led.off();
+	TEST_ASSERT_EQUAL(0, led.stagePattern(&fast));
+	TEST_ASSERT_EQUAL(1, last_value(PIN_LED_A));
+	led.off();
+	TEST_ASSERT_EQUAL(0, sched.pending());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_state(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led_a(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	Led led_b(PIN_LED_B, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	Led led_c(PIN_LED_C, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	LedState st = LedState();
+	// estado inicial
+	TEST_ASSERT_EQUAL(0, led_a.getState(st));
+	TEST_ASSERT_EQUAL(PIN_LED_A, st.id);
+	TEST_ASSERT_EQUAL(LedState::ModeOff, st.mode);
+	TEST_ASSERT_EQUAL(0, st.timeToEdge(sched.now()));
+	// parpadeo: intensidad actual y tiempo hasta el siguiente flanco
+	led_a.blink(100, 100);
+	VirtualClock::advance(30000);
+	TEST_ASSERT_EQUAL(0, led_a.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModeBlinking, st.mode);
+	TEST_ASSERT_EQUAL(0xFFFF, st.intensity);
+	TEST_ASSERT_EQUAL(70000, st.timeToEdge(sched.now()));
+	VirtualClock::advance(100000);
+	TEST_ASSERT_EQUAL(0, led_a.getState(st));
+	TEST_ASSERT_EQUAL(0, st.intensity);
+	TEST_ASSERT_EQUAL(70000, st.timeToEdge(sched.now()));
+	// rampa: intensidad de destino
+	led_b.on(0, 100, 1000);
+	VirtualClock::advance(500000);
+	TEST_ASSERT_EQUAL(0, led_b.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModeOn, st.mode);
+	TEST_ASSERT_TRUE((st.flags & LedState::FlagRamp) != 0);
+	TEST_ASSERT_EQUAL(0xFFFF, st.target);
+	TEST_ASSERT_TRUE(st.intensity > 0 && st.intensity < 0xFFFF);
+	VirtualClock::advance(600000);
+	TEST_ASSERT_EQUAL(0, led_b.getState(st));
+	TEST_ASSERT_EQUAL(0, st.flags);
+	TEST_ASSERT_EQUAL(0xFFFF, st.intensity);
+	// patrón: posición de la siguiente instrucción y capa visible
+	static constexpr LedPatternOp ops[] = {
+		LedPatternOp::set(100, 100),
+		LedPatternOp::set(0, 100),
+		LedPatternOp::jump(0),
+	};
+	static constexpr LedPattern pat(ops, 3);
+	led_c.play(&pat, 10000, Led::LayerAlarm);
+	TEST_ASSERT_EQUAL(0, led_c.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModePlaying, st.mode);
+	TEST_ASSERT_EQUAL(Led::LayerAlarm, st.layer);
+	TEST_ASSERT_EQUAL(1, st.pattern_pc);
+	VirtualClock::advance(150000);
+	TEST_ASSERT_EQUAL(0, led_c.getState(st));
+	TEST_ASSERT_EQUAL(2, st.pattern_pc);
+	TEST_ASSERT_EQUAL(0, st.intensity);
+	TEST_ASSERT_EQUAL(50000, st.timeToEdge(sched.now()));
+	{
+		// tabla: instantánea de todas las entradas en una única copia
+		LedStateTableT<2> table;
+		LedState snap[4];
+		TEST_ASSERT_EQUAL(0, table.attach(&led_a));
+		TEST_ASSERT_EQUAL(0, table.attach(&led_b));
+		TEST_ASSERT_EQUAL(-1, table.attach(&led_c));
+		TEST_ASSERT_EQUAL(-1, table.snapshot(snap, 1));
+		TEST_ASSERT_EQUAL(2, table.snapshot(snap, 4));
+		TEST_ASSERT_EQUAL(PIN_LED_A, snap[0].id);
+		TEST_ASSERT_EQUAL(LedState::ModeBlinking, snap[0].mode);
+		TEST_ASSERT_EQUAL(PIN_LED_B, snap[1].id);
+		TEST_ASSERT_EQUAL(LedState::ModeOn, snap[1].mode);
+		// los leds asociados publican en la tabla
+		VirtualClock::advance(100000);
+		TEST_ASSERT_EQUAL(2, table.snapshot(snap, 4));
+		TEST_ASSERT_EQUAL(0, led_a.getState(st));
+		TEST_ASSERT_EQUAL(st.intensity, snap[0].intensity);
+		TEST_ASSERT_EQUAL(st.next_edge, snap[0].next_edge);
+		// una entrada liberada se reutiliza
+		TEST_ASSERT_EQUAL(0, table.detach(&led_a));
+		TEST_ASSERT_EQUAL(-1, table.detach(&led_a));
+		TEST_ASSERT_EQUAL(2, table.snapshot(snap, 4));
+		TEST_ASSERT_EQUAL(LedState::ModeNone, snap[0].mode);
+		TEST_ASSERT_EQUAL(0, table.attach(&led_c));
+		TEST_ASSERT_EQUAL(2, table.snapshot(snap, 4));
+		TEST_ASSERT_EQUAL(PIN_LED_C, snap[0].id);
+		TEST_ASSERT_EQUAL(LedState::ModePlaying, snap[0].mode);
+		TEST_ASSERT_EQUAL(0, table.detach(&led_b));
+		TEST_ASSERT_EQUAL(1, table.size());
+	}
+	// al destruir la tabla los leds vuelven a publicar en su propio almacenamiento
+	led_c.off(0, 0, 0, Led::LayerAlarm);
+	TEST_ASSERT_EQUAL(0, led_c.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModeOff, st.mode);
+	TEST_ASSERT_EQUAL(0, led_a.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModeBlinking, st.mode);
+	// grupo
+	LedGroupT<2> group(&sched);
+	group.join(&led_a);
+	TEST_ASSERT_EQUAL(0, led_a.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModeGrouped, st.mode);
+	group.leave(&led_a);
+	led_a.off();
+	led_b.off();
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_scheduler_capacity(){
+	VirtualClock::reset();
+	// montículo dinámico: crece con las reservas de los leds
+	LedScheduler sched(8);
+	std::vector<Led*> leds;
+	for(int i=0;i<300;i++){
+		leds.push_back(new Led(100 + i, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched));
+	}
+	TEST_ASSERT_TRUE(sched.capacity() >= 300 * 4);
+	uint64_t t0 = VirtualClock::now();
+	for(int i=0;i<300;i++){
+		leds[i]->blink(100, 100);
+	}
+	VirtualClock::advance(150000);
+	for(int i=0;i<300;i++){
+		TEST_ASSERT_EQUAL(t0 + 100000, last_time(100 + i));
+		TEST_ASSERT_EQUAL(0, last_value(100 + i));
+		TEST_ASSERT_TRUE(leds[i]->isReady());
+	}
+	LedSchedulerStats stats;
+	stats.clear();
+	TEST_ASSERT_EQUAL(0, sched.getStats(stats));
+	TEST_ASSERT_EQUAL(0, stats.arm_failures);
+	for(int i=0;i<300;i++){
+		delete(leds[i]);
+	}
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	// almacenamiento externo: la reserva no se admite y las planificaciones rechazadas se contabilizan
+	LedSchedulerT<2> small;
+	Led a(PIN_LED_A, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &small);
+	TEST_ASSERT_FALSE(a.isReady());
+	Led b(PIN_LED_B, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &small);
+	Led c(PIN_LED_C, Led::LedOnOffType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &small);
+	a.blink(100, 100);
+	b.blink(100, 100);
+	c.blink(100, 100);
+	TEST_ASSERT_EQUAL(0, small.getStats(stats));
+	TEST_ASSERT_EQUAL(1, stats.arm_failures);
+	a.off();
+	b.off();
+	c.off();
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_scheduler_idle(){
+	VirtualClock::reset();
+	LedScheduler sched;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	// rampa de 100ms: al finalizar no quedan eventos y el timer se detiene
+	led.on(0, 100, 100);
+	VirtualClock::advance(200000);
+	TEST_ASSERT_EQUAL(0, sched.pending());
+	VirtualClock::clearWrites();
+	VirtualClock::advance(60000000);
+	TEST_ASSERT_EQUAL(0, VirtualClock::getCallbackCount());
+	// parpadeo detenido con off()
+	led.blink(100, 100);
+	VirtualClock::advance(1000000);
+	led.off();
+	VirtualClock::clearWrites();
+	VirtualClock::advance(60000000);
+	TEST_ASSERT_EQUAL(0, VirtualClock::getCallbackCount());
+	// cancelación del último evento antes de su vencimiento
+	static LedScheduler::Event evt;
+	TEST_ASSERT_EQUAL(0, sched.schedule(&evt, callback(slack_probe_cb), 10000000));
+	sched.cancel(&evt);
+	VirtualClock::clearWrites();
+	VirtualClock::advance(60000000);
+	TEST_ASSERT_EQUAL(0, VirtualClock::getCallbackCount());
+	TEST_ASSERT_EQUAL(0, VirtualClock::getActiveTickers());
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_footprint(){
+	// presupuesto en el host (64 bits): las estadísticas y el estado publicado no residen en el objeto
+	static const size_t LED_SIZE_BUDGET = 640;
+	TEST_ASSERT_TRUE(sizeof(Led) <= LED_SIZE_BUDGET);
+	VirtualClock::reset();
+	LedScheduler sched;
+	LedStats storage;
+	Led led(PIN_LED_A, Led::LedDimmableType, Led::OnIsHighLevel, PWM_PERIOD_MS, NULL, &sched);
+	// sin tabla de estados, el estado se obtiene bajo demanda
+	LedState st;
+	TEST_ASSERT_EQUAL(0, led.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModeOff, st.mode);
+	led.attachStats(&storage);
+	led.on();
+	TEST_ASSERT_EQUAL(0, led.getState(st));
+	TEST_ASSERT_EQUAL(LedState::ModeOn, st.mode);
+	LedStats stats;
+	TEST_ASSERT_EQUAL(0, led.getStats(stats));
+	TEST_ASSERT_EQUAL(led.getWritesIssued(), stats.writes_issued);
+	led.attachStats(NULL);
+	TEST_ASSERT_EQUAL(-1, led.getStats(stats));
+}
+
+
+//------------------------------------------------------------------------------------
+//-- TEST CASES ----------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Apagado por defecto, on y off instantaneos", "[Driver_Led]") {
+	test_led_default_off();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Logica inversa y correccion gamma", "[Driver_Led]") {
+	test_led_low_level_gamma();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Parpadeo 250/250", "[Driver_Led]") {
+	test_led_blink();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Rampa: duracion total exacta", "[Driver_Led]") {
+	test_led_ramp_end_time();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Rampa: pasos monotonos alineados al periodo pwm", "[Driver_Led]") {
+	test_led_ramp_monotonic();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Estado temporal restaura el anterior", "[Driver_Led]") {
+	test_led_temporal();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Modo de parpadeo por lista", "[Driver_Led]") {
+	test_led_blink_mode();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Un unico timer para todos los leds", "[Driver_Led]") {
+	test_led_single_timer();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("LedT: salida y nivel en tiempo de compilacion", "[Driver_Led]") {
+	test_led_static_output();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Banco de leds en memoria estatica", "[Driver_Led]") {
+	test_led_static_storage();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Cola de comandos aplicada en el contexto del timer", "[Driver_Led]") {
+	test_led_command_queue();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Deriva del parpadeo en 24h", "[Driver_Led]") {
+	test_led_drift_24h();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Grupo de parpadeo en fase", "[Driver_Led]") {
+	test_led_group();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Banco de leds en arrays contiguos", "[Driver_Led]") {
+	test_led_bank();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Modulacion BAM en salidas digitales", "[Driver_Led]") {
+	test_led_bam();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Supresion de escrituras redundantes", "[Driver_Led]") {
+	test_led_shadow();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Patron compilado compartido entre leds", "[Driver_Led]") {
+	test_led_pattern();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Registro de patrones compartido por la flota", "[Driver_Led]") {
+	test_led_pattern_registry();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Capas de prioridad con expiracion propia", "[Driver_Led]") {
+	test_led_layers();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Registro de trazas sin bloqueos", "[Driver_Led]") {
+	test_led_trace();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Estadisticas por led y agregadas", "[Driver_Led]") {
+	test_led_stats();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Intensidad de 16 bits y dithering temporal", "[Driver_Led]") {
+	test_led_dithering();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("ColorLed: transicion sincronizada de canales", "[Driver_Led]") {
+	test_color_led();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Formas de onda precalculadas con doble buffer", "[Driver_Led]") {
+	test_led_waveform();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Agrupacion de despertares por tolerancia", "[Driver_Led]") {
+	test_scheduler_slack();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Cambio de patron con doble buffer sin cortes", "[Driver_Led]") {
+	test_led_stage();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Consulta del estado sin bloqueos", "[Driver_Led]") {
+	test_led_state();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Capacidad del planificador segun el numero de leds", "[Driver_Led]") {
+	test_scheduler_capacity();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Sin despertares del timer en reposo", "[Driver_Led]") {
+	test_scheduler_idle();
+}
+
+
+TEST_CASE("Ocupacion de memoria del led", "[Driver_Led]") {
+	test_led_footprint();
+}
+
+
+
+//------------------------------------------------------------------------------------
+//-- TEST ENRY POINT -----------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+int main(int argc, char* argv[]){
+	return unity_run_all((argc > 1)? argv[1] : NULL);
+}
@@ -0,0 +1,81 @@
+/*
+ * trace_decode.cpp
+ *
+ *	Decodificador de volcados de LedTrace. Lee el volcado binario (fichero o entrada estándar) y emite una
+ *  línea de tiempo con un evento por línea: instante relativo al primer registro en microsegundos, id del
+ *  led, evento y argumento.
+ *
+ *  Uso:
+ *      trace_decode [volcado.bin]
+ */
+
+#include "LedTrace.h"
+#include <stdlib.h>
+#include <vector>
+
+
+//------------------------------------------------------------------------------------
+static const char* layer_name(uint8_t layer){
+    static const char* const names[] = { "base", "notification", "alarm" };
+    return (layer < 3)? names[layer] : "?";
+}
+
+
+//------------------------------------------------------------------------------------
+static void print_arg(uint8_t event, uint16_t arg, uint8_t aux){
+    switch(event){
+        case LedTrace::EvOn:
+        case LedTrace::EvOff:
+        case LedTrace::EvBlink:
+            printf("level=%u (%.1f%%) layer=%s", arg, (arg * 100.0) / 0xFFFF, layer_name(aux));
+            break;
+        case LedTrace::EvPlay:
+            printf("layer=%s", layer_name((uint8_t)arg));
+            break;
+        case LedTrace::EvExpiryCb:
+            printf("top=%s", layer_name((uint8_t)arg));
+            break;
+        case LedTrace::EvSetBlinkMode:
+            printf("count=%u", arg);
+            break;
+        case LedTrace::EvCancelBlinkMode:
+            break;
+        default:
+            printf("level=%u (%.1f%%)", arg, (arg * 100.0) / 0xFFFF);
+            break;
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+int main(int argc, char* argv[]){
+    FILE* f = (argc > 1)? fopen(argv[1], "rb") : stdin;
+    if(f == NULL){
+        fprintf(stderr, "trace_decode: no se puede abrir %s\n", argv[1]);
+        return 1;
+    }
+    LedTraceHeader hdr;
+    if(fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != LedTrace::Magic || hdr.version != LedTrace::Version || hdr.record_size != sizeof(LedTraceRecord)){
+        fprintf(stderr, "trace_decode: volcado no válido\n");
+        return 1;
+    }
+    std::vector<LedTraceRecord> records(hdr.count);
+    if(hdr.count > 0 && fread(&records[0], sizeof(LedTraceRecord), hdr.count, f) != hdr.count){
+        fprintf(stderr, "trace_decode: volcado truncado\n");
+        return 1;
+    }
+    if(f != stdin){
+        fclose(f);
+    }
+    printf("# %u eventos, %u perdidos, %u Hz\n", hdr.count, hdr.lost, hdr.tick_hz);
+    // el contador de ciclos desborda: se acumulan incrementos de 32 bits
+    uint64_t ticks = 0;
+    for(uint32_t i=0;i<hdr.count;i++){
+        const LedTraceRecord& r = records[i];
+        ticks += (i == 0)? 0 : (uint32_t)(r.ticks - records[i - 1].ticks);
+        printf("%12.3f us  seq=%-8u led=%-6u %-16s ", (ticks * 1000000.0) / hdr.tick_hz, r.seq, r.id, LedTrace::getEventName(r.event));
+        print_arg(r.event, r.arg, r.aux);
+        printf("\n");
+    }
+    return 0;
+}
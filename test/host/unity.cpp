@@ -0,0 +1,67 @@
+/*
+ * unity.cpp
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ */
+
+#include "unity.h"
+#include <string.h>
+
+
+//------------------------------------------------------------------------------------
+//--- PRIVATE TYPES ------------------------------------------------------------------
+//------------------------------------------------------------------------------------
+
+static UnityTestCase* s_first = NULL;
+static UnityTestCase* s_last = NULL;
+static bool s_failed = false;
+
+
+//------------------------------------------------------------------------------------
+//-- PUBLIC METHODS IMPLEMENTATION ---------------------------------------------------
+//------------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------------
+UnityTestCase::UnityTestCase(const char* n, const char* t, UnityTestFn f) : name(n), tag(t), fn(f), next(NULL){
+    // se mantiene el orden de declaración
+    if(s_last == NULL){
+        s_first = this;
+    }
+    else{
+        s_last->next = this;
+    }
+    s_last = this;
+}
+
+
+//------------------------------------------------------------------------------------
+void unity_fail(const char* file, int line, const char* expr, long long expected, long long actual){
+    printf("  %s:%d: FAIL %s (esperado %lld, obtenido %lld)\n", file, line, expr, expected, actual);
+    // a diferencia de Unity no se aborta el test: los objetos locales deben destruirse para no dejar eventos planificados
+    s_failed = true;
+}
+
+
+//------------------------------------------------------------------------------------
+int unity_run_all(const char* filter){
+    int run = 0, failed = 0;
+    for(UnityTestCase* tc = s_first; tc != NULL; tc = tc->next){
+        if(filter != NULL && strstr(tc->name, filter) == NULL && strstr(tc->tag, filter) == NULL){
+            continue;
+        }
+        run++;
+        s_failed = false;
+        tc->fn();
+        if(!s_failed){
+            printf("PASS %s %s\n", tc->tag, tc->name);
+        }
+        else{
+            failed++;
+            printf("FAIL %s %s\n", tc->tag, tc->name);
+        }
+    }
+    printf("-----------------------\n%d Tests %d Failures\n", run, failed);
+    return (failed == 0)? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * unity.h
+ *
+ *  Created on: Oct 2026
+ *      Author: raulMrello
+ *
+ *	Sustituto mínimo de Unity para ejecutar los tests en el host con la misma sintaxis que en el target
+ *  (TEST_CASE y TEST_ASSERT_xxx). Cada TEST_CASE se registra automáticamente y unity_run_all() los ejecuta.
+ *
+ */
+
+#ifndef __unity_host__H
+#define __unity_host__H
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+typedef void (*UnityTestFn)();
+
+/** Registro de un test */
+struct UnityTestCase{
+    const char* name;
+    const char* tag;
+    UnityTestFn fn;
+    UnityTestCase* next;
+    UnityTestCase(const char* n, const char* t, UnityTestFn f);
+};
+
+void unity_fail(const char* file, int line, const char* expr, long long expected, long long actual);
+int unity_run_all(const char* filter);
+
+#define UNITY_CONCAT2(a, b)     a##b
+#define UNITY_CONCAT(a, b)      UNITY_CONCAT2(a, b)
+
+#define TEST_CASE(name, tag) \
+    static void UNITY_CONCAT(unity_test_, __LINE__)(); \
+    static UnityTestCase UNITY_CONCAT(unity_case_, __LINE__)(name, tag, &UNITY_CONCAT(unity_test_, __LINE__)); \
+    static void UNITY_CONCAT(unity_test_, __LINE__)()
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do{ long long _e = (long long)(expected), _a = (long long)(actual); \
+        if(_e != _a){ unity_fail(__FILE__, __LINE__, #actual, _e, _a); } }while(0)
+
+#define TEST_ASSERT_TRUE(cond) \
+    do{ if(!(cond)){ unity_fail(__FILE__, __LINE__, #cond, 1, 0); } }while(0)
+
+#define TEST_ASSERT_FALSE(cond) \
+    do{ if(cond){ unity_fail(__FILE__, __LINE__, #cond, 0, 1); } }while(0)
+
+#define TEST_ASSERT_NOT_NULL(ptr) \
+    do{ if((ptr) == NULL){ unity_fail(__FILE__, __LINE__, #ptr " != NULL", 1, 0); } }while(0)
+
+#define TEST_ASSERT_INT_WITHIN(delta, expected, actual) \
+    do{ long long _e = (long long)(expected), _a = (long long)(actual); \
+        if(((_a - _e) > (long long)(delta)) || ((_e - _a) > (long long)(delta))){ unity_fail(__FILE__, __LINE__, #actual, _e, _a); } }while(0)
+
+
+#endif /*__unity_host__H */
+
+/**** END OF FILE ****/
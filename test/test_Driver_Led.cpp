@@ -1,7 +1,7 @@
 /*
  * test_Driver_Led.cpp
  *
- *	Test unitario para el mdulo Driver_Led
+ *	Test unitario para el módulo Driver_Led
  */
 
 
@@ -32,9 +32,9 @@ const PinName32 LedArray[] =	{PinName32_LED_RED_REMOTE, PinName32_LED_GREEN_REMO
 /** Requerido para test unitarios STM32 */
 #elif __MBED__ == 1 && defined(ENABLE_TEST_DEBUGGING) && defined(ENABLE_TEST_Driver_Led)
 #include "unity_test_runner.h"
-/// Configuracin MBED_API_uSerial
+/// Configuración MBED_API_uSerial
 
-// Configuracin leds
+// Configuración leds
 #define PinName32_LED_RED_LOCAL		PA_8
 #define PinName32_LED_GREEN_LOCAL		PA_9
 #define PinName32_LED_WHITE_LOCAL		PA_10
@@ -42,6 +42,7 @@ const PinName32 LedArray[] = {PinName32_LED_RED_LOCAL, PinName32_LED_GREEN_LOCAL
 #endif
 
 #define LED_COUNT				3
+#define BENCH_EVENT_COUNT		64
 
 
 //------------------------------------------------------------------------------------
@@ -64,7 +65,7 @@ bool are_locals = false;
 static xLed* xled[LED_COUNT];
 bool are_remotes = false;
 
-/** Librera userial */
+/** Librería userial */
 static MBED_API_uSerial mbed_api_userial;
 
 
@@ -85,7 +86,7 @@ static void test_led_init_userial(){
 	#endif
 	TEST_ASSERT_EQUAL(result, 0);
 
-	DEBUG_TRACE_I(_EXPR_, _MODULE_, "Esperando a que MBED_API_uSerial est operativa");
+	DEBUG_TRACE_I(_EXPR_, _MODULE_, "Esperando a que MBED_API_uSerial esté operativa");
 	while(!mbed_api_userial.ready()){
 		Thread::wait(100);
 	}
@@ -172,6 +173,90 @@ static void test_led_destroy(){
 	}
 }
 
+
+//------------------------------------------------------------------------------------
+static void bench_dummy_cb(){
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_sched_benchmark(){
+	static Ticker tickers[BENCH_EVENT_COUNT];
+	static LedScheduler::Event events[BENCH_EVENT_COUNT];
+	LedScheduler sched(BENCH_EVENT_COUNT);
+	Timer t;
+
+	// planificación mediante un Ticker por evento
+	t.start();
+	for(int i=0;i<BENCH_EVENT_COUNT;i++){
+		tickers[i].attach_us(callback(bench_dummy_cb), 1000000 + (i * 1000));
+	}
+	for(int i=0;i<BENCH_EVENT_COUNT;i++){
+		tickers[i].detach();
+	}
+	int ticker_us = t.read_us();
+
+	// planificación en el planificador compartido
+	t.reset();
+	for(int i=0;i<BENCH_EVENT_COUNT;i++){
+		TEST_ASSERT_EQUAL(sched.schedule(&events[i], callback(bench_dummy_cb), 1000000 + (i * 1000)), 0);
+	}
+	for(int i=0;i<BENCH_EVENT_COUNT;i++){
+		sched.cancel(&events[i]);
+	}
+	int sched_us = t.read_us();
+	TEST_ASSERT_EQUAL(sched.pending(), 0);
+
+	DEBUG_TRACE_I(_EXPR_, _MODULE_, "%d eventos: Ticker::attach_us/detach=%dus, LedScheduler::schedule/cancel=%dus", BENCH_EVENT_COUNT, ticker_us, sched_us);
+	// el planificador compartido no debe ser más lento que un Ticker por evento
+	TEST_ASSERT_TRUE(sched_us <= ticker_us);
+}
+
+
+//------------------------------------------------------------------------------------
+static uint32_t bench_idle_loop(){
+	// iteraciones de un bucle ocioso durante 1s: el tiempo consumido por las interrupciones las reduce
+	volatile uint32_t count = 0;
+	Timer t;
+	t.start();
+	while(t.read_us() < 1000000){
+		count++;
+	}
+	return count;
+}
+
+
+//------------------------------------------------------------------------------------
+static void test_led_ramp_benchmark(){
+	Led* leds[LED_COUNT];
+	LedScheduler sched;
+	uint32_t idle = bench_idle_loop();
+
+	// rampas de 1s en todos los leds: cada paso es un rampCb real (Q16, escritura del pwm) desde el timer
+	for(int i=0;i<LED_COUNT;i++){
+		leds[i] = new Led(LedArray[i], Led::LedDimmableType, Led::OnIsHighLevel, 1, NULL, &sched);
+		TEST_ASSERT_NOT_NULL(leds[i]);
+	}
+	// los callbacks se cuentan en el agregado global (sin estadísticas propias por led)
+	LedStats stats0, stats;
+	TEST_ASSERT_EQUAL(Led::getGlobalStats(stats0), 0);
+	for(int i=0;i<LED_COUNT;i++){
+		leds[i]->on(0, 100, 1000);
+	}
+	uint32_t busy = bench_idle_loop();
+
+	TEST_ASSERT_EQUAL(Led::getGlobalStats(stats), 0);
+	uint32_t callbacks = stats.callbacks[LedStats::CbRamp] - stats0.callbacks[LedStats::CbRamp];
+	for(int i=0;i<LED_COUNT;i++){
+		delete(leds[i]);
+	}
+	TEST_ASSERT_TRUE(callbacks > 0);
+	uint32_t ns = (idle > busy)? (uint32_t)((((uint64_t)(idle - busy) * 1000000000ULL) / idle) / callbacks) : 0;
+
+	DEBUG_TRACE_I(_EXPR_, _MODULE_, "%d rampas de 1s: %d rampCb, %dns por callback", LED_COUNT, callbacks, ns);
+}
+
+
 //------------------------------------------------------------------------------------
 //-- TEST CASES ----------------------------------------------------------------------
 //------------------------------------------------------------------------------------
@@ -218,6 +303,18 @@ TEST_CASE("Destruye los leds", "[Driver_Led]") {
 }
 
 
+//------------------------------------------------------------------------------------
+TEST_CASE("Benchmark planificador compartido vs Ticker", "[Driver_Led]") {
+	test_led_sched_benchmark();
+}
+
+
+//------------------------------------------------------------------------------------
+TEST_CASE("Benchmark del callback de rampa (rampCb)", "[Driver_Led]") {
+	test_led_ramp_benchmark();
+}
+
+
 
 
 //------------------------------------------------------------------------------------